@@ -1,6 +1,7 @@
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
 #include <string.h>
+#include "powerframe.h"
 /* USER CODE END Includes */
 
 /* USER CODE BEGIN PV */
@@ -16,6 +17,9 @@ extern UART_HandleTypeDef huart2;
 // 100毫欧电阻对应的校准值 (LSB=0.1mA)
 #define CAL_VALUE   0x0200      
 
+// 1: 发送二进制 PowerFrame (21 字节/通道); 0: 发送文本行 (便于串口助手调试)
+#define USE_BINARY_FRAME 1
+
 // --- 升级后的 I2C 读写函数 (增加 addr 参数) ---
 void INA226_WriteReg(uint16_t addr, uint8_t reg, uint16_t value) {
     uint8_t data[3];
@@ -39,6 +43,7 @@ int main(void)
 
   /* USER CODE BEGIN 2 */
   char debug_msg[128]; 
+  PowerFrame_t frame;
 
   // --- 1. 开机检测两个传感器 ---
   printf("System Start. Checking Dual INA226...\r\n");
@@ -86,9 +91,14 @@ int main(void)
       float cur1 = i1_raw * 0.0001f;
       float pow1 = vol1 * cur1;
 
-      // 发送通道 1 (加前缀 CH:1)
+      // 发送通道 1
+#if USE_BINARY_FRAME
+      PowerFrame_Build(&frame, 1, HAL_GetTick(), vol1, cur1 * 1000.0f, pow1 * 1000.0f);
+      HAL_UART_Transmit(&huart2, (uint8_t*)&frame, sizeof(frame), 20);
+#else
       sprintf(debug_msg, "CH:1 V=%.3f V | I=%.4f A | P=%.4f W\r\n", vol1, cur1, pow1);
       HAL_UART_Transmit(&huart2, (uint8_t*)debug_msg, strlen(debug_msg), 20);
+#endif
 
 
       // --- 读取通道 2 数据 ---
@@ -99,9 +109,14 @@ int main(void)
       float cur2 = i2_raw * 0.0001f;
       float pow2 = vol2 * cur2;
 
-      // 发送通道 2 (加前缀 CH:2)
+      // 发送通道 2
+#if USE_BINARY_FRAME
+      PowerFrame_Build(&frame, 2, HAL_GetTick(), vol2, cur2 * 1000.0f, pow2 * 1000.0f);
+      HAL_UART_Transmit(&huart2, (uint8_t*)&frame, sizeof(frame), 20);
+#else
       sprintf(debug_msg, "CH:2 V=%.3f V | I=%.4f A | P=%.4f W\r\n", vol2, cur2, pow2);
       HAL_UART_Transmit(&huart2, (uint8_t*)debug_msg, strlen(debug_msg), 20);
+#endif
 
       // 心跳与刷新
       HAL_GPIO_TogglePin(LD3_GPIO_Port, LD3_Pin);
@@ -0,0 +1,29 @@
+/*
+ * powerframe.c
+ *
+ * 二进制采样帧打包
+ */
+
+#include "powerframe.h"
+
+uint16_t PowerFrame_CRC16(const uint8_t *data, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t b = 0; b < 8; ++b) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void PowerFrame_Build(PowerFrame_t *f, uint8_t ch, uint32_t ts, float v, float i_ma, float p_mw) {
+    // Cortex-M 为小端序，结构体内存布局即线上格式
+    f->header    = POWERFRAME_HEADER;
+    f->channel   = ch;
+    f->timestamp = ts;
+    f->voltage   = v;
+    f->current   = i_ma;
+    f->power     = p_mw;
+    f->crc16     = PowerFrame_CRC16((const uint8_t *)f, POWERFRAME_SIZE - 2);
+}
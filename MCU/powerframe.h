@@ -0,0 +1,42 @@
+/*
+ * powerframe.h
+ *
+ * 二进制采样帧 (PowerFrame)，与上位机 QT/powerframe.h 保持一致。
+ * 线上格式: 小端序, 紧凑排列, 共 21 字节
+ *   header(0xAA55) | channel | timestamp(ms) | V | mA | mW | crc16
+ * crc16 = CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)，覆盖 crc16 之前的全部字节
+ */
+
+#ifndef INC_POWERFRAME_H_
+#define INC_POWERFRAME_H_
+
+#include <stdint.h>
+
+#define POWERFRAME_HEADER    0xAA55
+#define POWERFRAME_SIZE      21
+
+#pragma pack(push, 1)
+typedef struct {
+    uint16_t header;      // 0xAA55 (线上先发 0x55)
+    uint8_t  channel;     // 通道号, 从 1 开始
+    uint32_t timestamp;   // HAL_GetTick(), ms
+    float    voltage;     // V
+    float    current;     // mA
+    float    power;       // mW
+    uint16_t crc16;
+} PowerFrame_t;
+#pragma pack(pop)
+
+/**
+ * @brief 计算 CRC-16/CCITT-FALSE
+ */
+uint16_t PowerFrame_CRC16(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief 填充一帧并计算 CRC，随后可直接 HAL_UART_Transmit(&frame, sizeof(frame))
+ * @param i_ma: 电流 (mA)
+ * @param p_mw: 功率 (mW)
+ */
+void PowerFrame_Build(PowerFrame_t *f, uint8_t ch, uint32_t ts, float v, float i_ma, float p_mw);
+
+#endif /* INC_POWERFRAME_H_ */
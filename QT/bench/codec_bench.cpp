@@ -0,0 +1,379 @@
+// CodecBench：压缩段编解码的往返校验与压缩比
+//
+// 1. XorCodec 各编码的往返：NaN（含带载荷的）、±0、非规格化数、±Inf、随机位模式、
+//    整段相同、时间偏移的极值；从位流中间的段起点解码。解码结果须与原值逐位相同。
+// 2. SampleStore 整条路径：样本写满块、压缩成段（内存 / 落盘两种），退役后从压缩段读回，
+//    值和时间戳须与热数据时读到的一致；低频采样 (时间块 shift > 0) 也在内。聚合与逐点求和比对。
+// 3. 压缩比：几种典型负载每样本的字节数（含段头），对比原来的 PowerData (3 × double + 时间戳，32 B)
+//    和裸列存 (3 × float + 64 位时间戳，20 B)；另测从压缩段顺序读出的速度。
+//    文本负载按固件格式格式化后经 SerialWorker::tryParse 解析，与实际收到的 float 一致。
+// 任何一项往返不一致时返回 1。
+
+#include "samplestore.h"
+#include "serialworker.h"
+#include "xorcodec.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace XorCodec;
+
+namespace {
+
+constexpr int kBlock = SampleStore::kBlock;        // 时间戳块，也是段内子块
+constexpr quint64 kRatioSamples = 1 << 20;         // 每种负载写入的样本数
+constexpr double kOriginalBytes = 32.0;            // 原 PowerData：double v, i, p + quint64 t
+constexpr double kRawBytes = 20.0;                 // float v, i, p + quint64 t_ns
+
+int g_failures = 0;
+volatile double g_sink = 0.0; // 读出的数据要用掉，免得被优化
+
+QTextStream& out() {
+    static QTextStream s(stdout);
+    return s;
+}
+
+void fail(const QString& what) {
+    ++g_failures;
+    out() << "  !! " << what << "\n";
+    out().flush();
+}
+
+quint32 bits(float f) { quint32 u; std::memcpy(&u, &f, 4); return u; }
+float fromBits(quint32 u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+bool sameBits(const float* a, const float* b, int n) {
+    for (int k = 0; k < n; ++k) {
+        if (bits(a[k]) != bits(b[k])) return false;
+    }
+    return true;
+}
+
+// ---- 1. 编码原语
+
+// 特殊值与普通值混排的测试块
+std::vector<std::vector<float>> floatCases() {
+    const float inf = std::numeric_limits<float>::infinity();
+    const float denormMin = std::numeric_limits<float>::denorm_min();
+    const float normMin = std::numeric_limits<float>::min();
+    std::vector<std::vector<float>> cases;
+
+    std::vector<float> special = { 0.0f, -0.0f, 0.0f, -0.0f, fromBits(0x7FC00000u), fromBits(0x7FC00001u),
+                                   fromBits(0xFFC12345u), fromBits(0x7F800001u), inf, -inf, denormMin, -denormMin,
+                                   normMin - denormMin, fromBits(0x00000F00u), normMin, std::numeric_limits<float>::max(),
+                                   -std::numeric_limits<float>::max(), 1.0f, 12.0f, -12.0f };
+    special.resize(kBlock, fromBits(0x7FC00000u));
+    cases.push_back(special);
+
+    cases.push_back(std::vector<float>(kBlock, 12.345f));        // 整段相同
+    cases.push_back(std::vector<float>(kBlock, -0.0f));
+    cases.push_back(std::vector<float>(kBlock, denormMin * 3));
+
+    std::mt19937 rng(7);
+    std::vector<float> random(kBlock), denorms(kBlock), quantized(kBlock), mixed(kBlock);
+    for (int k = 0; k < kBlock; ++k) {
+        random[k] = fromBits(rng());                              // 任意位模式，含 NaN
+        denorms[k] = fromBits(rng() & 0x807FFFFFu);               // 全是非规格化数 / ±0
+        quantized[k] = float(double(9600 + int(rng() % 7) - 3) / 800.0); // 1.25 mV 刻度
+        mixed[k] = (k % 9 == 4) ? fromBits(0x7FC00000u) : quantized[k];  // 刻度值中间夹 NaN
+    }
+    cases.push_back(random);
+    cases.push_back(denorms);
+    cases.push_back(quantized);
+    cases.push_back(mixed);
+    return cases;
+}
+
+void checkFloats() {
+    const auto cases = floatCases();
+
+    // 所有块连续写进同一个位流，记下每块起点，再从各自起点解码
+    std::vector<quint64> words;
+    std::vector<quint64> starts[3];
+    std::vector<int> scales;
+    {
+        BitWriter w(words);
+        for (const auto& c : cases) {
+            starts[0].push_back(w.bitPos());
+            encodeFloats(w, c.data(), kBlock);
+
+            starts[1].push_back(w.bitPos());
+            std::vector<float> pred(c);
+            for (float& p : pred) p = fromBits(bits(p) ^ 0x3u); // 预测差最低两位
+            encodePredicted(w, c.data(), pred.data(), kBlock);
+
+            starts[2].push_back(w.bitPos());
+            const int scale = findScale(c.data(), kBlock);
+            scales.push_back(scale);
+            if (scale >= 0) encodeScaled(w, c.data(), kBlock, scale);
+        }
+        w.flush();
+        words.push_back(0); // BitReader 可能多看一个字
+    }
+
+    for (size_t k = 0; k < cases.size(); ++k) {
+        const auto& c = cases[k];
+        float got[kBlock];
+
+        BitReader r0(words.data(), starts[0][k]);
+        decodeFloats(r0, got, kBlock);
+        if (!sameBits(c.data(), got, kBlock)) fail(QString("xor round trip, case %1").arg(k));
+
+        std::vector<float> pred(c);
+        for (float& p : pred) p = fromBits(bits(p) ^ 0x3u);
+        BitReader r1(words.data(), starts[1][k]);
+        decodePredicted(r1, pred.data(), got, kBlock);
+        if (!sameBits(c.data(), got, kBlock)) fail(QString("predicted round trip, case %1").arg(k));
+
+        if (scales[k] >= 0) {
+            BitReader r2(words.data(), starts[2][k]);
+            decodeScaled(r2, got, kBlock, scales[k]);
+            if (!sameBits(c.data(), got, kBlock)) fail(QString("scaled round trip, case %1").arg(k));
+        }
+    }
+
+    // 刻度只能用在能逐位还原的块上：特殊值块必须落选，刻度块必须选中
+    if (scales[0] >= 0) fail("findScale accepted NaN / -0 / denormals");
+    if (scales[2] >= 0) fail("findScale accepted -0");
+    if (scales[3] >= 0) fail("findScale accepted denormals");
+    if (scales[6] < 0 || scaleDivisor(scales[6]) != 800.0) fail("findScale missed the 1.25 mV scale");
+    if (scales[7] >= 0) fail("findScale accepted a block with NaN");
+    out() << QString("floats: %1 blocks x 3 codecs round trip\n").arg(cases.size());
+}
+
+void checkOffsets() {
+    std::vector<std::vector<quint32>> cases;
+    std::vector<quint32> c(kBlock);
+    for (int k = 0; k < kBlock; ++k) c[k] = quint32(k) * 1000000u;   // 1 kHz
+    cases.push_back(c);
+    for (int k = 0; k < kBlock; ++k) c[k] = (k % 2) ? 0xFFFFFFFFu : 0u; // 二阶差分最大
+    cases.push_back(c);
+    for (int k = 0; k < kBlock; ++k) c[k] = 0xFFFFFFFFu - quint32(k);
+    cases.push_back(c);
+    std::mt19937 rng(11);
+    for (int k = 0; k < kBlock; ++k) c[k] = rng();
+    cases.push_back(c);
+    for (int k = 0; k < kBlock; ++k) c[k] = quint32(k / 16) * 15000000u; // 同一次读取共用时间戳
+    cases.push_back(c);
+
+    std::vector<quint64> words;
+    std::vector<quint64> starts;
+    {
+        BitWriter w(words);
+        for (const auto& oc : cases) {
+            starts.push_back(w.bitPos());
+            encodeOffsets(w, oc.data(), kBlock);
+        }
+        w.flush();
+        words.push_back(0);
+    }
+    for (size_t k = 0; k < cases.size(); ++k) {
+        quint32 got[kBlock];
+        BitReader r(words.data(), starts[k]);
+        decodeOffsets(r, got, kBlock);
+        if (std::memcmp(got, cases[k].data(), sizeof(got)) != 0) fail(QString("offset round trip, case %1").arg(k));
+    }
+    out() << QString("offsets: %1 blocks round trip\n").arg(cases.size());
+}
+
+// ---- 2/3. 负载
+
+struct Sample {
+    float v, i, p;
+    quint64 t;
+};
+
+// 一种负载：逐个样本生成，与 PowerSim / 固件的量化一致
+class Load {
+public:
+    enum Kind { Quiet, Steps, Text, LowRate, Random };
+
+    explicit Load(Kind kind) : m_kind(kind) {}
+
+    static const char* name(Kind kind) {
+        switch (kind) {
+        case Quiet:   return "quiet";
+        case Steps:   return "steps";
+        case Text:    return "text";
+        case LowRate: return "lowrate";
+        case Random:  return "random";
+        }
+        return "";
+    }
+
+    Sample next() {
+        const quint64 k = m_k++;
+        Sample s;
+        if (m_kind == Random) {
+            s = { fromBits(m_rng()), fromBits(m_rng()), fromBits(m_rng()), 0 };
+            m_t += 1 + m_rng() % 5000000;
+            s.t = m_t;
+            return s;
+        }
+
+        // 与 PowerSim 一致：12 V 源，0.2 Ω 内阻，INA226 量化（1.25 mV、0.1 mA）
+        double i_ma = 100.0 + m_noise(m_rng) * (m_kind == Quiet ? 0.3 : 2.0);
+        if (m_kind != Quiet) {
+            if ((k / 500) % 2) i_ma += 500.0;                       // 0.5 s 一次阶跃
+            if (k % 5000 < 8) i_ma += 1500.0;                       // 冲击电流
+        }
+        double v = 12.0 - 0.2 * i_ma / 1000.0 + m_noise(m_rng) * 0.0005;
+        v = std::round(v / 0.00125) * 0.00125;
+        i_ma = std::round(i_ma / 0.1) * 0.1;
+        const double p_mw = v * i_ma;
+
+        if (m_kind == Text) {
+            // 与 PowerSim 的文本行相同，经解析器换算成 mA / mW
+            char line[96];
+            const int len = std::snprintf(line, sizeof(line), "CH:1 V=%.3f V | I=%.4f A | P=%.4f W",
+                                          v, i_ma / 1000.0, p_mw / 1000.0);
+            ParsedSample ps;
+            SerialWorker::tryParse(line, line + len, ps);
+            s.v = ps.v;
+            s.i = ps.i;
+            s.p = ps.p;
+            // 主机读到数据的时刻：一次读取 16 行，共用一个时间戳
+            if (k % 16 == 0) m_t += 16000000 + m_rng() % 200000;
+            s.t = m_t;
+        } else {
+            s.v = float(v);
+            s.i = float(i_ma);
+            s.p = float(p_mw);
+            // 设备时间戳经 ClockSync 对齐：1 ms 间隔，80 ppm 漂移
+            const quint64 step = (m_kind == LowRate) ? 100000000ULL : 1000000ULL;
+            s.t = 5000000000ULL + quint64(std::llround(double(k) * double(step) * (1.0 + 80e-6)));
+        }
+        return s;
+    }
+
+private:
+    Kind m_kind;
+    quint64 m_k = 0;
+    quint64 m_t = 5000000000ULL;
+    std::mt19937 m_rng{ 3 };
+    std::normal_distribution<double> m_noise{ 0.0, 1.0 };
+};
+
+// 写入 n 个样本，记下每个样本在热数据里读到的值；退役到压缩段后逐个比对
+void checkStore(Load::Kind kind, const QString& spillPath) {
+    const quint64 n = 200000; // 整数个时间戳块
+    SampleStore store(SampleStore::kDefaultCapacity, qint64(64) << 20);
+    if (!spillPath.isEmpty() && !store.enableSpill(spillPath)) {
+        fail("enableSpill failed");
+        return;
+    }
+
+    Load load(kind);
+    std::vector<Sample> ref;
+    ref.reserve(n);
+    for (quint64 k = 0; k < n; ++k) {
+        const Sample s = load.next();
+        store.push(s.v, s.i, s.p, s.t);
+        ref.push_back(s);
+        // 时间戳以热数据为准：低频时块内偏移会降精度 (shift > 0)，块写满后才定下来
+        if ((k + 1) % kBlock == 0) {
+            for (quint64 j = k + 1 - kBlock; j <= k; ++j) ref[j].t = store.time(j);
+        }
+    }
+    store.publish();
+
+    const SampleView view = store.view();
+    const QString where = QString("%1 %2").arg(Load::name(kind), spillPath.isEmpty() ? "memory" : "disk");
+    if (view.firstIndex() != 0 || view.lastIndex() != n || store.hotBegin() == 0) {
+        fail(where + ": history not kept in compressed segments");
+        return;
+    }
+
+    quint64 bad = 0;
+    for (quint64 k = 0; k < n; ++k) {
+        const PowerData d = view.at(qint64(k));
+        const Sample& r = ref[k];
+        if (bits(d.v) != bits(r.v) || bits(d.i) != bits(r.i) || bits(d.p) != bits(r.p) || d.t_ns != r.t) ++bad;
+    }
+    if (bad) fail(QString("%1: %2 samples differ after round trip").arg(where).arg(bad));
+
+    // 聚合：整段 / 整子块走段头，零头解码；与逐点累加比对
+    std::mt19937 rng(5);
+    bool aggBad = false;
+    for (int q = 0; q < 2000 && !aggBad && kind != Load::Random; ++q) {
+        quint64 a = rng() % n, b = rng() % n;
+        if (a > b) std::swap(a, b);
+        const ChannelAgg agg = view.aggregate(qint64(a), qint64(b - a));
+        for (int s = 0; s < kSeriesCount; ++s) {
+            SeriesAgg expect;
+            for (quint64 k = a; k < b; ++k) expect.add(s == 0 ? ref[k].v : s == 1 ? ref[k].i : ref[k].p);
+            const SeriesAgg& got = agg.series[s];
+            // 求和顺序不同，只差舍入
+            auto near = [](double x, double y) { return std::fabs(x - y) <= 1e-9 * std::max(1.0, std::fabs(y)); };
+            if (got.n != expect.n || got.min != expect.min || got.max != expect.max ||
+                !near(got.sum, expect.sum) || !near(got.sumSq, expect.sumSq)) {
+                fail(QString("%1: aggregate [%2, %3) mismatch in series %4").arg(where).arg(a).arg(b).arg(s));
+                aggBad = true;
+                break;
+            }
+        }
+    }
+    out() << QString("store %1: %2 samples round trip%3\n").arg(where).arg(n).arg(bad || aggBad ? " FAILED" : "");
+}
+
+void ratio(Load::Kind kind) {
+    // 热数据只留两块，其余全部压成段
+    SampleStore store(2 * SampleStore::kSegment, qint64(1) << 40);
+    Load load(kind);
+    for (quint64 k = 0; k < kRatioSamples; ++k) {
+        const Sample s = load.next();
+        store.push(s.v, s.i, s.p, s.t);
+    }
+    store.publish();
+
+    const quint64 sealed = kRatioSamples / SampleStore::kSegment * SampleStore::kSegment;
+    const double perSample = double(store.compressedBytes()) / double(sealed);
+
+    // 顺序读出整段压缩历史（每段解码一次）
+    const SampleView cold = store.view().subspan(0, qint64(store.hotBegin()));
+    QElapsedTimer t;
+    t.start();
+    double sink = 0.0;
+    cold.forEachBlock([&](qint64, const float* const cols[kSeriesCount], int n) {
+        for (int j = 0; j < n; ++j) sink += cols[0][j] + cols[1][j] + cols[2][j];
+    });
+    const double sec = t.nsecsElapsed() / 1e9;
+    g_sink = sink;
+
+    out() << QString("%1 %2 %3 %4 %5\n")
+                 .arg(Load::name(kind), -8)
+                 .arg(perSample, 10, 'f', 2)
+                 .arg(kOriginalBytes / perSample, 10, 'f', 1)
+                 .arg(kRawBytes / perSample, 10, 'f', 1)
+                 .arg(double(cold.size()) / sec / 1e6, 12, 'f', 1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    checkFloats();
+    checkOffsets();
+
+    QTemporaryDir dir;
+    for (Load::Kind kind : { Load::Quiet, Load::Steps, Load::Text, Load::LowRate, Load::Random }) {
+        checkStore(kind, QString());
+        if (dir.isValid()) checkStore(kind, dir.filePath(QString("%1.seg").arg(Load::name(kind))));
+    }
+
+    out() << QString("\n%1 %2 %3 %4 %5\n")
+                 .arg("load", -8).arg("B/sample", 10).arg("vs 32 B", 10).arg("vs 20 B", 10).arg("decode MS/s", 12);
+    for (Load::Kind kind : { Load::Quiet, Load::Steps, Load::Text, Load::LowRate, Load::Random }) ratio(kind);
+
+    out() << (g_failures ? QString("\n%1 check(s) FAILED\n").arg(g_failures) : QString("\nall round trips ok\n"));
+    return g_failures ? 1 : 0;
+}
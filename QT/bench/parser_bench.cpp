@@ -0,0 +1,197 @@
+// ParserBench：解析器 / 帧解码 / 分行逻辑的吞吐基准
+//
+// 输出每项的 lines/s (或 frames/s) 与 MB/s。语料：
+//   clean   固件正常输出的文本行
+//   noisy   夹杂开机信息 (System/OK:/ERR:)、半截行和乱码的文本行
+//   binary  二进制 PowerFrame
+//   mixed   开机文本 + 二进制帧 + 偶发误码
+// feed 项按不同读取粒度切片，模拟 USB-CDC / UART 的碎片化读取。
+
+#include "serialworker.h"
+#include "powerframe.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr qint64 kMinBenchNs = 500 * 1000 * 1000; // 每项至少跑 0.5 s
+constexpr int kCorpusSamples = 200000;
+
+struct Corpus {
+    QString name;
+    QByteArray bytes;
+    int samples = 0; // 期望解出的样本数
+};
+
+QByteArray textLine(int ch, double v, double i_a, double p_w) {
+    char line[96];
+    int len = std::snprintf(line, sizeof(line), "CH:%d V=%.3f V | I=%.4f A | P=%.4f W\r\n", ch, v, i_a, p_w);
+    return QByteArray(line, len);
+}
+
+QByteArray frame(int ch, quint32 ts, float v, float i_ma, float p_mw) {
+    char buf[PowerFrame::kSize];
+    PowerFrame::encode({ quint8(ch), ts, v, i_ma, p_mw }, buf);
+    return QByteArray(buf, PowerFrame::kSize);
+}
+
+Corpus makeClean(int n) {
+    Corpus c{ "clean", {}, n };
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> d(0.0, 1.0);
+    for (int k = 0; k < n; ++k) {
+        double v = 12.0 + d(rng) * 0.1, i = 0.1 + d(rng) * 0.5;
+        c.bytes += textLine(1 + k % 2, v, i, v * i);
+    }
+    return c;
+}
+
+Corpus makeNoisy(int n) {
+    Corpus c{ "noisy", {}, n };
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> d(0.0, 1.0);
+    c.bytes += "System Start. Checking Dual INA226...\r\n";
+    c.bytes += "OK: Sensor 1 (0x80) Found.\r\n";
+    c.bytes += "ERR: Sensor 2 (0x82) Missing! Check A0 jumper.\r\n";
+    for (int k = 0; k < n; ++k) {
+        double v = 12.0 + d(rng) * 0.1, i = 0.1 + d(rng) * 0.5;
+        c.bytes += textLine(1 + k % 2, v, i, v * i);
+        switch (rng() % 16) {
+        case 0: c.bytes += "OK: Sensor 1 (0x80) Found.\r\n"; break;
+        case 1: c.bytes += "CH:1 V=12.3"; c.bytes += "\r\n"; break;        // 半截行
+        case 2: c.bytes += "\x01\x7f#@!garbage\r\n"; break;               // 乱码
+        case 3: c.bytes += "\r\n"; break;                                  // 空行
+        default: break;
+        }
+    }
+    return c;
+}
+
+Corpus makeBinary(int n) {
+    Corpus c{ "binary", {}, n };
+    for (int k = 0; k < n; ++k) c.bytes += frame(1 + k % 2, quint32(k), 12.0f, 100.0f + k % 50, 1200.0f);
+    return c;
+}
+
+Corpus makeMixed(int n) {
+    Corpus c{ "mixed", {}, 0 };
+    std::mt19937 rng(3);
+    c.bytes += "System Start. Checking Dual INA226...\r\n";
+    c.bytes += "OK: Sensor 1 (0x80) Found.\r\n";
+    for (int k = 0; k < n; ++k) {
+        QByteArray f = frame(1 + k % 2, quint32(k), 12.0f, 100.0f, 1200.0f);
+        if (rng() % 1000 == 0) f[int(rng() % f.size())] ^= 0x10; // 误码，CRC 失败
+        else c.samples++;
+        c.bytes += f;
+    }
+    return c;
+}
+
+struct Result {
+    double itemsPerSec;
+    double mbPerSec;
+};
+
+template <typename F>
+Result timeIt(qint64 bytesPerRun, qint64 itemsPerRun, F&& run) {
+    QElapsedTimer t;
+    t.start();
+    qint64 runs = 0;
+    do { run(); ++runs; } while (t.nsecsElapsed() < kMinBenchNs);
+    const double s = t.nsecsElapsed() / 1e9;
+    return { itemsPerRun * runs / s, bytesPerRun * runs / s / (1024.0 * 1024.0) };
+}
+
+void print(const QString& what, const QString& corpus, const Result& r, const QString& unit) {
+    QTextStream(stdout) << QString("%1 %2 %3 %4/s %5 MB/s\n")
+                               .arg(what, -24)
+                               .arg(corpus, -8)
+                               .arg(r.itemsPerSec, 14, 'f', 0)
+                               .arg(unit, -6)
+                               .arg(r.mbPerSec, 9, 'f', 1);
+}
+
+// 只测 tryParse：预先切好行，不含分行开销
+void benchTryParse(const Corpus& c) {
+    std::vector<std::pair<int, int>> lines;
+    for (int b = 0, e; (e = c.bytes.indexOf('\n', b)) >= 0; b = e + 1) lines.push_back({ b, e - b });
+
+    volatile int sink = 0;
+    Result r = timeIt(c.bytes.size(), qint64(lines.size()), [&]() {
+        ParsedSample s;
+        int ok = 0;
+        const char* base = c.bytes.constData();
+        for (const auto& l : lines) ok += SerialWorker::tryParse(base + l.first, base + l.first + l.second, s);
+        sink = sink + ok;
+    });
+    print("tryParse", c.name, r, "lines");
+}
+
+void benchDecode(const Corpus& c) {
+    const qint64 n = c.bytes.size() / PowerFrame::kSize;
+    volatile int sink = 0;
+    Result r = timeIt(n * PowerFrame::kSize, n, [&]() {
+        ParsedSample s;
+        int ok = 0;
+        const char* p = c.bytes.constData();
+        for (qint64 k = 0; k < n; ++k) ok += SerialWorker::tryDecodeFrame(p + k * PowerFrame::kSize, s);
+        sink = sink + ok;
+    });
+    print("tryDecodeFrame", c.name, r, "frames");
+}
+
+// 完整接收路径：环形缓冲 + 分行/找帧头 + 解析 + 入队
+// chunk <= 0 时每次随机 1..4096 字节
+void benchFeed(const Corpus& c, int chunk) {
+    SerialWorker worker(nullptr, 1 << 20);
+    std::mt19937 rng(4);
+    bool countOk = true;
+
+    Result r = timeIt(c.bytes.size(), c.samples, [&]() {
+        const char* p = c.bytes.constData();
+        qint64 left = c.bytes.size();
+        qint64 got = 0;
+        while (left > 0) {
+            qint64 k = (chunk > 0) ? chunk : qint64(1 + rng() % 4096);
+            k = qMin(k, left);
+            worker.feed(p, k);
+            p += k;
+            left -= k;
+            got += qint64(worker.ring().drain([](const ParsedSample&) {}));
+        }
+        if (got != c.samples) countOk = false;
+    });
+
+    QString label = (chunk > 0) ? QString("feed chunk=%1").arg(chunk) : QString("feed chunk=rand");
+    print(label, c.name, r, "samples");
+    if (!countOk) QTextStream(stdout) << "  !! sample count mismatch\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    const Corpus clean = makeClean(kCorpusSamples);
+    const Corpus noisy = makeNoisy(kCorpusSamples);
+    const Corpus binary = makeBinary(kCorpusSamples);
+    const Corpus mixed = makeMixed(kCorpusSamples);
+
+    QTextStream(stdout) << QString("corpus: clean %1 KB, noisy %2 KB, binary %3 KB, mixed %4 KB\n")
+                               .arg(clean.bytes.size() / 1024).arg(noisy.bytes.size() / 1024)
+                               .arg(binary.bytes.size() / 1024).arg(mixed.bytes.size() / 1024);
+
+    benchTryParse(clean);
+    benchTryParse(noisy);
+    benchDecode(binary);
+
+    for (const Corpus* c : { &clean, &noisy, &binary, &mixed }) {
+        for (int chunk : { 1, 7, 64, 4096, 0 }) benchFeed(*c, chunk);
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+// ScopeBench：示波器离屏绘制基准
+//
+// 在 offscreen 平台上构造 Oscilloscope，喂 1 万到 1 亿个样本的合成历史（超出内存的部分落盘），
+// 按 宽度 × 缩放 × 回看位置 × 迹线开关 逐项计时，输出 ms/frame 与每帧的内存分配次数 / KB。
+// 缩放被示波器限制住的组合（比整段历史铺满宽度还小）跳过，与 fit 重复。
+// 一帧 = setData + paintEvent 提交渲染 + 渲染线程画完 + paintEvent 贴图，与界面上的一帧一致。
+//   live  offset 0，每帧先追加 1000 个样本（不计时）：实时增量滚动
+//         历史随之变长，samples 一列是该项最后一帧实际的历史长度
+//   mid   回看到历史中部，每帧在相邻两个位置间切换：整幅重画
+//   old   回看到最旧处（磁盘段）：整幅重画 + 解码
+// 分配次数统计本程序所有线程的 operator new，Qt 内部直接 malloc 的（如 QImage 像素）不计。
+// 开头另测 SeriesAgg::add（聚合里连续样本的那一段）的吞吐，与单条累加链的写法对比。
+
+#include "oscilloscope.h"
+#include "samplestore.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+std::atomic<quint64> g_allocs{ 0 };
+std::atomic<quint64> g_allocBytes{ 0 };
+
+} // namespace
+
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr qint64 kMinBenchNs = 300 * 1000 * 1000; // 每项至少跑 0.3 s
+constexpr int kMinFrames = 5;
+constexpr int kWarmupFrames = 2;
+constexpr int kLiveAppend = 1000;                 // live 每帧新增的样本
+constexpr int kHeight = 300;
+
+// 1 kHz 采样的合成负载：12 V 附近小幅波动，正弦电流 + 每 5000 个样本一次 8 个样本宽的冲击电流
+struct Generator {
+    quint64 k = 0;
+    quint32 seed = 1;
+
+    float noise() {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1u << 24) - 0.5f;
+    }
+    void push(SampleStore& store, quint64 n) {
+        for (quint64 end = k + n; k < end; ++k) {
+            const float v = 12.0f + 0.02f * noise();
+            const float i = 100.0f + 50.0f * std::sin(float(k % 6283) * 0.001f) + noise() + ((k % 5000) < 8 ? 1500.0f : 0.0f);
+            store.push(v, i, v * i, k * 1000000ULL);
+        }
+    }
+};
+
+// 单条累加链：SeriesAgg::add 拆成四路之前的写法，作对比用
+SeriesAgg addChain(const float* p, int count) {
+    SeriesAgg r;
+    float lo = p[0], hi = p[0];
+    double s = 0.0, sq = 0.0;
+    for (int j = 0; j < count; ++j) {
+        lo = qMin(lo, p[j]);
+        hi = qMax(hi, p[j]);
+        s += p[j];
+        sq += double(p[j]) * p[j];
+    }
+    r.min = lo; r.max = hi; r.sum = s; r.sumSq = sq; r.n = count;
+    return r;
+}
+
+volatile double g_aggSink = 0.0;
+
+// 每次聚合 n 个连续样本，返回 M samples/s
+template <typename F>
+double aggregateRate(const std::vector<float>& col, int n, F&& f) {
+    quint64 samples = 0;
+    double sink = 0.0;
+    QElapsedTimer t;
+    t.start();
+    while (t.nsecsElapsed() < kMinBenchNs) {
+        for (size_t off = 0; off + size_t(n) <= col.size(); off += size_t(n)) {
+            const SeriesAgg a = f(col.data() + off, n);
+            sink += a.sum + a.max;
+            samples += quint64(n);
+        }
+    }
+    g_aggSink = sink;
+    return samples / (t.nsecsElapsed() / 1e3);
+}
+
+void aggregateThroughput(QTextStream& out) {
+    std::vector<float> col(HotChunk::kSize);
+    Generator gen;
+    for (float& x : col) x = 100.0f + 50.0f * gen.noise();
+
+    for (int n : { 64, 4096 }) { // 压缩段子块 / 整块
+        const double chain = aggregateRate(col, n, addChain);
+        const double lanes = aggregateRate(col, n, [](const float* p, int count) {
+            SeriesAgg a;
+            a.add(p, count);
+            return a;
+        });
+        out << QString("SeriesAgg::add, %1 samples/call: %2 M samples/s (single chain %3, x%4)\n")
+                   .arg(n).arg(lanes, 0, 'f', 0).arg(chain, 0, 'f', 0).arg(lanes / chain, 0, 'f', 2);
+    }
+    out.flush();
+}
+
+struct Traces {
+    const char* name;
+    bool v, i, p;
+};
+
+struct Result {
+    qint64 samples; // 最后一帧的历史长度
+    double msPerFrame;
+    double allocsPerFrame;
+    double kbPerFrame;
+};
+
+// 一帧：提交、等渲染线程画完、把结果送回 GUI 线程、再贴一次图
+void frame(Oscilloscope& scope, QImage& target, const SampleView& view, qint64 offset) {
+    scope.setData(view, offset, scope.zoom());
+    scope.render(&target);                // paintEvent：贴上一帧，提交这一帧
+    ScopeRenderer::pool()->waitForDone();
+    QCoreApplication::sendPostedEvents(); // onFrameRendered
+    scope.render(&target);                // paintEvent：贴刚画好的这一帧
+}
+
+// where: 0 live / 1 mid / 2 old
+Result run(Oscilloscope& scope, QImage& target, SampleStore& store, Generator& gen, int where) {
+    auto offsetFor = [&](const SampleView& view, int k) -> qint64 {
+        if (where == 0) return 0;
+        const qint64 visible = qint64(std::ceil(scope.width() / scope.zoom())) + 2;
+        const qint64 base = (where == 1) ? view.size() / 2 : qMax<qint64>(0, view.size() - visible - 2);
+        return qMin(base + (k & 1), view.size() - 1); // 相邻两个位置来回切，每帧都要整幅重画
+    };
+    auto next = [&](int k) {
+        if (where == 0) {
+            gen.push(store, kLiveAppend);
+            store.publish();
+        }
+        const SampleView view = store.view();
+        return std::make_pair(view, offsetFor(view, k));
+    };
+
+    int k = 0;
+    for (; k < kWarmupFrames; ++k) {
+        const auto in = next(k);
+        frame(scope, target, in.first, in.second);
+    }
+
+    qint64 ns = 0;
+    quint64 allocs = 0, bytes = 0;
+    int frames = 0;
+    qint64 samples = 0;
+    while (frames < kMinFrames || ns < kMinBenchNs) {
+        const auto in = next(k++);
+        samples = in.first.size();
+        const quint64 a0 = g_allocs.load(), b0 = g_allocBytes.load();
+        QElapsedTimer t;
+        t.start();
+        frame(scope, target, in.first, in.second);
+        ns += t.nsecsElapsed();
+        allocs += g_allocs.load() - a0;
+        bytes += g_allocBytes.load() - b0;
+        ++frames;
+    }
+    return { samples, ns / 1e6 / frames, double(allocs) / frames, bytes / 1024.0 / frames };
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ScopeBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("示波器离屏绘制基准");
+    parser.addHelpOption();
+    QCommandLineOption optMax("max-samples", "历史长度上限（默认 1 亿）", "n", "100000000");
+    parser.addOption(optMax);
+    parser.process(app);
+    const quint64 maxSamples = parser.value(optMax).toULongLong();
+
+    QTemporaryDir spillDir;
+    const Traces traces[] = { { "VIP", true, true, true }, { "V", true, false, false } };
+    const double zooms[] = { 0.0, 0.01, 1.0, 5.0 }; // 0 = 整段历史铺满宽度
+    const char* wheres[] = { "live", "mid", "old" };
+
+    QTextStream out(stdout);
+    aggregateThroughput(out);
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+               .arg("samples", 10).arg("width", 6).arg("zoom", 6).arg("where", 5).arg("traces", 6)
+               .arg("ms/frame", 10).arg("allocs/frame", 13).arg("KB/frame", 10);
+    out.flush();
+
+    for (quint64 n : { 10000ULL, 1000000ULL, 100000000ULL }) {
+        if (n > maxSamples) continue;
+
+        SampleStore store;
+        QString error = "no temporary directory";
+        if (!spillDir.isValid() || !store.enableSpill(spillDir.filePath("bench.seg"), &error)) {
+            out << QString("  !! spill disabled (%1), history limited to %2 samples\n").arg(error).arg(store.capacity());
+        }
+        Generator gen;
+        QElapsedTimer fillTimer;
+        fillTimer.start();
+        gen.push(store, n);
+        store.publish();
+        out << QString("filled %1 samples in %2 s\n").arg(n).arg(fillTimer.nsecsElapsed() / 1e9, 0, 'f', 2);
+        out.flush();
+
+        for (int width : { 400, 1920, 3840 }) {
+            Oscilloscope scope(QColor("#fdd835"), QColor("#ff9800"), QColor("#ff5252"));
+            scope.setAttribute(Qt::WA_DontShowOnScreen);
+            scope.resize(width, kHeight);
+            scope.show();
+            QImage target(scope.size(), QImage::Format_ARGB32_Premultiplied);
+
+            for (double zoom : zooms) {
+                for (int where = 0; where < 3; ++where) {
+                    for (const Traces& tr : traces) {
+                        scope.showV = tr.v;
+                        scope.showI = tr.i;
+                        scope.showP = tr.p;
+                        scope.setData(store.view(), 0, 1.0);
+                        scope.setZoom(zoom);
+                        if (zoom != 0.0 && scope.zoom() != zoom) continue;
+
+                        const Result r = run(scope, target, store, gen, where);
+                        out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                                   .arg(r.samples, 10).arg(width, 6)
+                                   .arg(zoom == 0.0 ? QString("fit") : QString::number(zoom), 6)
+                                   .arg(wheres[where], 5).arg(tr.name, 6)
+                                   .arg(r.msPerFrame, 10, 'f', 3)
+                                   .arg(r.allocsPerFrame, 13, 'f', 1)
+                                   .arg(r.kbPerFrame, 10, 'f', 1);
+                        out.flush();
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <QtGlobal>
+#include <cstring>
+#include <vector>
+
+// 定长环形字节缓冲（串口接收用）
+// 位置均为 64 位绝对流位置：begin() 是读游标，end() 是写游标，消费只移动游标，
+// 不搬移数据。查找用 memchr 分两段扫描（glibc 的 memchr 已是 SIMD 实现）。
+class ByteRing {
+public:
+    static constexpr qint64 npos = -1;
+
+    // 容量向上取整到 2 的幂
+    explicit ByteRing(int capacity) {
+        int cap = 64;
+        while (cap < capacity) cap <<= 1;
+        m_data.resize(cap);
+        m_mask = quint64(cap - 1);
+    }
+
+    int capacity() const { return int(m_mask + 1); }
+    int size() const { return int(m_end - m_begin); }
+    int freeSpace() const { return capacity() - size(); }
+    quint64 begin() const { return m_begin; }
+    quint64 end() const { return m_end; }
+
+    // ---- 写入：先取一段连续空闲区，直接读进去，再 commit
+    char* writeSpan(int& contiguous) {
+        const quint64 w = m_end & m_mask;
+        const quint64 r = m_begin & m_mask;
+        if (freeSpace() == 0) { contiguous = 0; return nullptr; }
+        contiguous = int((w >= r) ? (m_mask + 1 - w) : (r - w));
+        if (contiguous > freeSpace()) contiguous = freeSpace();
+        return m_data.data() + w;
+    }
+    void commit(int n) { m_end += quint64(n); }
+
+    // 拷贝写入（测试 / 基准用），返回实际写入字节数
+    int write(const char* src, int n) {
+        int done = 0;
+        while (done < n) {
+            int span = 0;
+            char* dst = writeSpan(span);
+            if (span == 0) break;
+            int k = qMin(span, n - done);
+            std::memcpy(dst, src + done, size_t(k));
+            commit(k);
+            done += k;
+        }
+        return done;
+    }
+
+    // ---- 读取
+    char at(quint64 pos) const { return m_data[pos & m_mask]; }
+
+    // 在 [from, end()) 中找字节 c
+    qint64 find(char c, quint64 from) const {
+        if (from < m_begin) from = m_begin;
+        while (from < m_end) {
+            const quint64 off = from & m_mask;
+            const quint64 span = qMin(m_end - from, m_mask + 1 - off);
+            const void* hit = std::memchr(m_data.data() + off, c, size_t(span));
+            if (hit) return qint64(from + quint64(static_cast<const char*>(hit) - (m_data.data() + off)));
+            from += span;
+        }
+        return npos;
+    }
+
+    // 找相邻两字节 a b；末尾只有 a 时不算命中
+    qint64 findPair(char a, char b, quint64 from) const {
+        while (true) {
+            qint64 k = find(a, from);
+            if (k == npos || quint64(k) + 1 >= m_end) return npos;
+            if (at(quint64(k) + 1) == b) return k;
+            from = quint64(k) + 1;
+        }
+    }
+
+    // [pos, pos+n) 的连续视图：不跨越回绕时直接返回内部指针，否则拷到 scratch
+    const char* contiguous(quint64 pos, int n, char* scratch) const {
+        const quint64 off = pos & m_mask;
+        if (off + quint64(n) <= m_mask + 1) return m_data.data() + off;
+        const int first = int(m_mask + 1 - off);
+        std::memcpy(scratch, m_data.data() + off, size_t(first));
+        std::memcpy(scratch + first, m_data.data(), size_t(n - first));
+        return scratch;
+    }
+
+    void consumeTo(quint64 pos) { m_begin = qMin(pos, m_end); }
+    void clear() { m_begin = m_end; }
+
+private:
+    std::vector<char> m_data;
+    quint64 m_mask = 0;
+    quint64 m_begin = 0;
+    quint64 m_end = 0;
+};
@@ -0,0 +1,237 @@
+#include "bytesource.h"
+#include <QSocketNotifier>
+#include <QUrlQuery>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// 文件回放：限速模式下的节拍，以及每拍最多送出的字节数
+static constexpr int kReplayTickMs = 10;
+static constexpr qint64 kReplayMaxChunk = 256 * 1024;
+
+ByteSource* ByteSource::create(const QString& spec, int baud, QObject* parent) {
+    if (spec.startsWith("file:")) {
+        QString rest = spec.mid(5);
+        QString path = rest.section('?', 0, 0);
+        QUrlQuery query(rest.section('?', 1));
+        qint64 rate = query.queryItemValue("rate").toLongLong();
+        bool loop = query.queryItemValue("loop") == "1";
+        return new FileReplaySource(path, rate, loop, parent);
+    }
+    if (spec.startsWith("pty:")) {
+        return new PtySource(spec.mid(4), parent);
+    }
+    if (spec.startsWith("tcp:")) {
+        QString rest = spec.mid(4);
+        int colon = rest.lastIndexOf(':');
+        QString host = (colon > 0) ? rest.left(colon) : QString("127.0.0.1");
+        quint16 port = (quint16)rest.mid(colon + 1).toUInt();
+        return new TcpSource(host, port, parent);
+    }
+    return new SerialSource(spec, baud, parent);
+}
+
+// ---------------- Serial ----------------
+
+SerialSource::SerialSource(const QString& portName, int baud, QObject* parent)
+    : ByteSource(parent), m_baud(baud)
+{
+    m_serial.setPortName(portName);
+    connect(&m_serial, &QSerialPort::readyRead, this, &ByteSource::readyRead);
+}
+
+bool SerialSource::open() {
+    m_serial.setBaudRate(m_baud);
+    m_serial.setDataBits(QSerialPort::Data8);
+    m_serial.setParity(QSerialPort::NoParity);
+    m_serial.setStopBits(QSerialPort::OneStop);
+    m_serial.setFlowControl(QSerialPort::NoFlowControl);
+
+    if (!m_serial.open(QIODevice::ReadOnly)) {
+        m_error = "无法打开串口：" + m_serial.errorString();
+        return false;
+    }
+    return true;
+}
+
+void SerialSource::close() {
+    if (m_serial.isOpen()) m_serial.close();
+}
+
+QString SerialSource::description() const {
+    return QString("串口 %1 @ %2").arg(m_serial.portName()).arg(m_baud);
+}
+
+// ---------------- File replay ----------------
+
+FileReplaySource::FileReplaySource(const QString& path, qint64 bytesPerSec, bool loop, QObject* parent)
+    : ByteSource(parent), m_file(path), m_rate(bytesPerSec), m_loop(loop)
+{
+    connect(&m_timer, &QTimer::timeout, this, &FileReplaySource::onTick);
+}
+
+bool FileReplaySource::open() {
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = "无法打开回放文件：" + m_file.errorString();
+        return false;
+    }
+    m_sent = 0;
+    m_clock.start();
+    m_timer.start(m_rate > 0 ? kReplayTickMs : 0);
+    return true;
+}
+
+void FileReplaySource::close() {
+    m_timer.stop();
+    if (m_file.isOpen()) m_file.close();
+}
+
+void FileReplaySource::onTick() {
+    m_tickBudget = kReplayMaxChunk;
+    emit readyRead();
+
+    if (m_file.atEnd() && !m_loop) {
+        m_timer.stop();
+        emit finished();
+    }
+}
+
+qint64 FileReplaySource::read(char* dst, qint64 maxLen) {
+    qint64 allowed = qMin(maxLen, m_tickBudget);
+    if (m_rate > 0) {
+        // 按墙钟换算应送出的总字节数
+        qint64 due = m_clock.elapsed() * m_rate / 1000 - m_sent;
+        allowed = qMin(allowed, due);
+    }
+    if (allowed <= 0) return 0;
+
+    qint64 n = m_file.read(dst, allowed);
+    if (n == 0 && m_loop && m_file.size() > 0) {
+        m_file.seek(0);
+        n = m_file.read(dst, allowed);
+    }
+    if (n <= 0) return 0;
+
+    m_sent += n;
+    m_tickBudget -= n;
+    return n;
+}
+
+QString FileReplaySource::description() const {
+    return QString("文件回放 %1 (%2%3)")
+        .arg(m_file.fileName())
+        .arg(m_rate > 0 ? QString("%1 B/s").arg(m_rate) : QString("不限速"))
+        .arg(m_loop ? ", 循环" : "");
+}
+
+// ---------------- Pseudo terminal ----------------
+
+PtySource::PtySource(const QString& slavePath, QObject* parent)
+    : ByteSource(parent), m_path(slavePath)
+{
+}
+
+PtySource::~PtySource() {
+    close();
+}
+
+bool PtySource::open() {
+#ifdef Q_OS_UNIX
+    if (m_path.isEmpty()) {
+        m_fd = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (m_fd < 0 || ::grantpt(m_fd) != 0 || ::unlockpt(m_fd) != 0) {
+            m_error = QString("无法创建伪终端：%1").arg(QString::fromLocal8Bit(std::strerror(errno)));
+            close();
+            return false;
+        }
+        m_path = QString::fromLocal8Bit(::ptsname(m_fd));
+        m_keepSlaveFd = ::open(m_path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+    } else {
+        m_fd = ::open(m_path.toLocal8Bit().constData(), O_RDONLY | O_NOCTTY);
+        if (m_fd < 0) {
+            m_error = QString("无法打开伪终端 %1：%2").arg(m_path, QString::fromLocal8Bit(std::strerror(errno)));
+            return false;
+        }
+    }
+
+    // 原始模式：不做 CR/LF 转换、不回显，二进制帧原样通过
+    termios tio;
+    if (::tcgetattr(m_fd, &tio) == 0) {
+        ::cfmakeraw(&tio);
+        ::tcsetattr(m_fd, TCSANOW, &tio);
+    }
+    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ByteSource::readyRead);
+    return true;
+#else
+    m_error = "当前平台不支持伪终端";
+    return false;
+#endif
+}
+
+void PtySource::close() {
+#ifdef Q_OS_UNIX
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_keepSlaveFd >= 0) ::close(m_keepSlaveFd);
+    if (m_fd >= 0) ::close(m_fd);
+#endif
+    m_keepSlaveFd = -1;
+    m_fd = -1;
+}
+
+qint64 PtySource::read(char* dst, qint64 maxLen) {
+#ifdef Q_OS_UNIX
+    if (m_fd < 0) return 0;
+    ssize_t n = ::read(m_fd, dst, size_t(maxLen));
+    if (n > 0) return n;
+    if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        // 对端永久关闭，停止监听避免空转
+        if (m_notifier) m_notifier->setEnabled(false);
+        emit finished();
+    }
+#else
+    Q_UNUSED(dst);
+    Q_UNUSED(maxLen);
+#endif
+    return 0;
+}
+
+QString PtySource::description() const {
+    return QString("伪终端 %1").arg(m_path);
+}
+
+// ---------------- TCP ----------------
+
+TcpSource::TcpSource(const QString& host, quint16 port, QObject* parent)
+    : ByteSource(parent), m_host(host), m_port(port)
+{
+    connect(&m_socket, &QTcpSocket::readyRead, this, &ByteSource::readyRead);
+    connect(&m_socket, &QTcpSocket::disconnected, this, &ByteSource::finished);
+}
+
+bool TcpSource::open() {
+    m_socket.connectToHost(m_host, m_port, QIODevice::ReadOnly);
+    if (!m_socket.waitForConnected(3000)) {
+        m_error = QString("无法连接 %1:%2：%3").arg(m_host).arg(m_port).arg(m_socket.errorString());
+        m_socket.abort();
+        return false;
+    }
+    return true;
+}
+
+void TcpSource::close() {
+    m_socket.abort();
+}
+
+QString TcpSource::description() const {
+    return QString("TCP %1:%2").arg(m_host).arg(m_port);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSerialPort>
+#include <QTcpSocket>
+
+class QSocketNotifier;
+
+// 字节流来源：串口 / 文件回放 / 伪终端 / TCP
+// SerialWorker 只依赖这个接口，换传输层不影响解析和下游
+class ByteSource : public QObject {
+    Q_OBJECT
+public:
+    explicit ByteSource(QObject* parent=nullptr) : QObject(parent) {}
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    // 非阻塞读取，没有数据时返回 0
+    virtual qint64 read(char* dst, qint64 maxLen) = 0;
+    // 日志里显示的描述
+    virtual QString description() const = 0;
+    QString errorString() const { return m_error; }
+
+    // 按描述串创建：
+    //   COM3 / /dev/ttyUSB0                 串口 (baud)
+    //   file:<path>[?rate=<B/s>&loop=1]     文件回放，rate=0 或省略表示尽快
+    //   pty:                                新建伪终端，外部程序写 slave 端
+    //   pty:<slave path>                    打开已有伪终端 (如模拟器创建的)
+    //   tcp:<host>:<port>                   TCP 客户端
+    static ByteSource* create(const QString& spec, int baud, QObject* parent=nullptr);
+
+signals:
+    void readyRead();
+    void finished(); // 回放结束 / 对端断开
+
+protected:
+    QString m_error;
+};
+
+class SerialSource : public ByteSource {
+    Q_OBJECT
+public:
+    SerialSource(const QString& portName, int baud, QObject* parent=nullptr);
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override { return m_serial.isOpen(); }
+    qint64 read(char* dst, qint64 maxLen) override { return m_serial.read(dst, maxLen); }
+    QString description() const override;
+
+private:
+    QSerialPort m_serial;
+    int m_baud;
+};
+
+class FileReplaySource : public ByteSource {
+    Q_OBJECT
+public:
+    // bytesPerSec <= 0：不限速
+    FileReplaySource(const QString& path, qint64 bytesPerSec, bool loop, QObject* parent=nullptr);
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override { return m_file.isOpen(); }
+    qint64 read(char* dst, qint64 maxLen) override;
+    QString description() const override;
+
+private:
+    void onTick();
+
+    QFile m_file;
+    qint64 m_rate;
+    bool m_loop;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_sent = 0;
+    qint64 m_tickBudget = 0; // 每次 readyRead 最多给出的字节数，避免长时间占住 IO 线程
+};
+
+class PtySource : public ByteSource {
+    Q_OBJECT
+public:
+    // slavePath 为空时新建一对伪终端，本端读 master
+    explicit PtySource(const QString& slavePath, QObject* parent=nullptr);
+    ~PtySource() override;
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override { return m_fd >= 0; }
+    qint64 read(char* dst, qint64 maxLen) override;
+    QString description() const override;
+
+private:
+    QString m_path;
+    int m_fd = -1;
+    int m_keepSlaveFd = -1; // 自己持有一份 slave，外部程序关闭时 master 不会 EIO
+    QSocketNotifier* m_notifier = nullptr;
+};
+
+class TcpSource : public ByteSource {
+    Q_OBJECT
+public:
+    TcpSource(const QString& host, quint16 port, QObject* parent=nullptr);
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override { return m_socket.state() == QAbstractSocket::ConnectedState; }
+    qint64 read(char* dst, qint64 maxLen) override { return m_socket.read(dst, maxLen); }
+    QString description() const override;
+
+private:
+    QTcpSocket m_socket;
+    QString m_host;
+    quint16 m_port;
+};
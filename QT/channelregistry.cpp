@@ -0,0 +1,31 @@
+#include "channelregistry.h"
+
+int ChannelRegistry::deviceId(const QString& name) {
+    int dev = m_devices.indexOf(name);
+    if (dev >= 0) return dev;
+
+    m_devices.append(name);
+    m_map.emplace_back();
+    m_map.back().fill(-1);
+    return m_devices.size() - 1;
+}
+
+int ChannelRegistry::channelIndex(int dev, int ch, bool* isNew) {
+    if (isNew) *isNew = false;
+    if (dev < 0 || dev >= (int)m_map.size() || ch < 1 || ch > kMaxDeviceChannel) return -1;
+
+    short& slot = m_map[dev][ch];
+    if (slot >= 0) return slot;
+    if (count() >= m_max) return -1;
+
+    slot = (short)count();
+    m_channels.push_back({ dev, ch });
+    if (isNew) *isNew = true;
+    return slot;
+}
+
+QString ChannelRegistry::label(int index) const {
+    const Entry& e = m_channels[index];
+    if (e.dev == 0) return QString("CH%1").arg(e.ch);
+    return QString("D%1 CH%2").arg(e.dev + 1).arg(e.ch);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <vector>
+
+// (设备, 通道号) -> 全局通道索引
+// 通道在第一次收到数据时才登记；没出现过的通道不占任何资源。
+// 同一个数据源描述串重连后沿用原来的设备号，历史曲线接着画。
+class ChannelRegistry {
+public:
+    static constexpr int kMaxDeviceChannel = 255; // 通道号 1..255
+
+    explicit ChannelRegistry(int maxChannels) : m_max(maxChannels) {}
+
+    // 按数据源描述串取设备号，不存在则新建
+    int deviceId(const QString& name);
+    QString deviceName(int dev) const { return m_devices.value(dev); }
+
+    // 返回全局通道索引，新登记时 *isNew = true；通道号非法或已满返回 -1
+    int channelIndex(int dev, int ch, bool* isNew = nullptr);
+
+    int count() const { return int(m_channels.size()); }
+    int maxChannels() const { return m_max; }
+    int deviceOf(int index) const { return m_channels[index].dev; }
+    int channelOf(int index) const { return m_channels[index].ch; }
+    // 第一个设备显示 "CH1"，其余设备显示 "D2 CH1"（登记后不再变化）
+    QString label(int index) const;
+
+private:
+    struct Entry { int dev; int ch; };
+
+    int m_max;
+    QStringList m_devices;
+    std::vector<std::array<short, kMaxDeviceChannel + 1>> m_map; // [dev][ch] -> index, -1 未登记
+    std::vector<Entry> m_channels;
+};
@@ -0,0 +1,112 @@
+#include "clocksync.h"
+
+// 设备时间戳倒退超过这么多且不是 u32 回绕，视为设备重启
+static constexpr quint32 kRebootBackstepMs = 1000;
+
+void ClockSync::reset() {
+    const qint64 lastOut = m_lastOutNs;
+    *this = ClockSync();
+    m_lastOutNs = lastOut;
+}
+
+qint64 ClockSync::unwrap(quint32 devMs) {
+    if (m_started && devMs < m_lastDevMs) {
+        const quint32 back = m_lastDevMs - devMs;
+        if (back > 0x80000000u) {
+            ++m_wraps; // u32 回绕 (约 49.7 天)
+        } else if (back > kRebootBackstepMs) {
+            reset();   // 设备重启，重新对齐
+        }
+    }
+    m_started = true;
+    m_lastDevMs = devMs;
+    return ((m_wraps << 32) + qint64(devMs)) * 1000000LL;
+}
+
+qint64 ClockSync::map(quint32 devMs, qint64 hostNs) {
+    qint64 devNs = unwrap(devMs);
+    if (m_minima.empty() && !m_bucketOpen) m_originNs = devNs;
+
+    const double dev = double(devNs - m_originNs);
+    const double off = double(hostNs - devNs);
+
+    // ---- 修正量按经过的设备时间收回
+    const double maxStep = kMaxSlew * qMax(0.0, dev - m_dev);
+    m_corr -= qBound(-maxStep, m_corr, maxStep);
+    m_dev = dev;
+
+    // ---- 下包络：每个桶只保留最小的 host - dev
+    if (m_bucketOpen && dev - m_bucketStart >= double(kBucketNs)) closeBucket();
+    if (!m_bucketOpen) {
+        m_bucketOpen = true;
+        m_bucketStart = dev;
+        m_bucketMin = { dev, off };
+    } else if (off < m_bucketMin.off) {
+        m_bucketMin = { dev, off };
+    }
+
+    // ---- 估计偏移
+    double estOff = target(dev);
+    if (m_fitted && off < estOff) {
+        // 比预测更早到达：说明估计偏大，整体下移
+        m_intercept -= estOff - off;
+        estOff = off;
+    }
+    estOff += m_corr;
+    if (off < estOff) {
+        // 还在收回的修正量不能让结果晚于实际到达
+        m_corr -= estOff - off;
+        estOff = off;
+    }
+
+    // 偏移下调时输出停住，不倒退
+    const qint64 t = qMax(devNs + qint64(estOff), m_lastOutNs);
+    m_lastOutNs = t;
+    return t;
+}
+
+double ClockSync::target(double dev) const {
+    // 第一个桶内还没有斜率，用当前最小值
+    return m_fitted ? m_intercept + m_slope * dev : m_bucketMin.off;
+}
+
+void ClockSync::closeBucket() {
+    // 直线的跳变记进修正量，输出连续
+    const double before = target(m_dev);
+    m_minima.push_back(m_bucketMin);
+    while ((int)m_minima.size() > kMaxBuckets) m_minima.pop_front();
+    m_bucketOpen = false;
+    refit();
+    m_corr += before - target(m_dev);
+}
+
+void ClockSync::refit() {
+    const int n = (int)m_minima.size();
+    if (n == 1) {
+        m_slope = 0.0;
+        m_intercept = m_minima.front().off;
+        m_fitted = true;
+        return;
+    }
+
+    double sx = 0, sy = 0;
+    for (const Point& p : m_minima) { sx += p.dev; sy += p.off; }
+    const double mx = sx / n, my = sy / n;
+
+    double sxx = 0, sxy = 0;
+    for (const Point& p : m_minima) {
+        sxx += (p.dev - mx) * (p.dev - mx);
+        sxy += (p.dev - mx) * (p.off - my);
+    }
+    m_slope = (sxx > 0) ? sxy / sxx : 0.0;
+
+    // 直线放到所有包络点之下，保证映射不晚于实际到达
+    double lowest = 0.0;
+    bool first = true;
+    for (const Point& p : m_minima) {
+        double r = p.off - m_slope * p.dev;
+        if (first || r < lowest) { lowest = r; first = false; }
+    }
+    m_intercept = lowest;
+    m_fitted = true;
+}
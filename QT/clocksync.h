@@ -0,0 +1,62 @@
+#pragma once
+#include <QtGlobal>
+#include <chrono>
+#include <deque>
+
+// 主机单调时钟 (ns)，各线程读数一致
+inline qint64 monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 设备时钟 -> 主机时钟的在线对齐
+//
+// 每个样本给出 (设备时间戳, 主机收到时刻)。两者之差 = 时钟偏移 + 传输延迟，延迟只会为正，
+// 所以取每个时间桶内差值的最小值 (下包络) 作为偏移观测，再对最近若干个桶做最小二乘，
+// 得到偏移和漂移 (斜率)。映射结果不会晚于主机实际收到的时刻。
+//
+// 重新拟合时直线会跳动，跳变量不直接加到输出上，而是记为修正量，按设备时间以
+// 不超过 kMaxSlew 的速率逐步收回 (slew)；输出另外夹住，不小于上一次的结果，
+// 时间戳单调不减 (跨 reset 也一样)。只有样本比映射结果更早到达时才立即下调偏移，
+// 这时输出停在上一次的值上，直到时间追上来。
+class ClockSync {
+public:
+    static constexpr qint64 kBucketNs = 1000LL * 1000 * 1000; // 1 s 一个桶
+    static constexpr int kMaxBuckets = 60;                    // 拟合最近 60 s
+    static constexpr double kMaxSlew = 500e-6;                // 修正速率上限：每秒设备时间最多 0.5 ms
+
+    // devMs: 设备毫秒时间戳 (u32，会回绕)；hostNs: monotonicNs()
+    // 返回该样本在主机时钟上的采样时刻 (ns)，单调不减
+    qint64 map(quint32 devMs, qint64 hostNs);
+    // 丢掉拟合状态，单调性保持
+    void reset();
+
+    bool fitted() const { return m_fitted; }
+    double driftPpm() const { return m_slope * 1e6; }
+
+private:
+    struct Point { double dev; double off; }; // dev: 相对 m_origin 的设备时间 (ns); off: host - dev
+
+    qint64 unwrap(quint32 devMs);
+    void closeBucket();
+    void refit();
+    double target(double dev) const; // 当前直线在 dev 处的偏移
+
+    bool m_started = false;
+    quint32 m_lastDevMs = 0;
+    qint64 m_wraps = 0;
+    qint64 m_originNs = 0;      // 第一个样本的设备时间，拟合时作为零点保证精度
+
+    bool m_bucketOpen = false;
+    double m_bucketStart = 0.0;
+    Point m_bucketMin{0.0, 0.0};
+    std::deque<Point> m_minima;
+
+    bool m_fitted = false;
+    double m_slope = 0.0;       // 漂移：每 ns 设备时间对应的偏移变化
+    double m_intercept = 0.0;   // dev = 0 处的偏移
+
+    double m_dev = 0.0;         // 上一个样本的 dev
+    double m_corr = 0.0;        // 实际使用的偏移 - 直线，逐步收回到 0
+    qint64 m_lastOutNs = 0;     // 上一次的输出
+};
@@ -0,0 +1,362 @@
+#include "coldstore.h"
+#include "xorcodec.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+using namespace XorCodec;
+using Header = ColdSegmentHeader;
+
+struct DecodedSegment {
+    quint64 store = ~quint64(0);
+    quint64 first = ~quint64(0);
+    quint64 lastUse = 0;
+    float col[kSeriesCount][Header::kSize];
+    quint64 t[Header::kSize];
+};
+
+namespace {
+
+// 已解码段缓存，每个线程一份，读快照不需要加锁
+// 按 store 分组：store 编号顺序分配，同时在用的不超过 kSets 个（每通道一个）时各占一组，
+// 导出、逐点绘制这类按行交替读各通道的访问不会互相挤掉。条目用到才分配
+struct DecodeCache {
+    static constexpr int kSets = 64;
+    static constexpr int kWays = 2; // 视图跨段边界时前后两段都留着
+    std::unique_ptr<DecodedSegment> entries[kSets][kWays];
+    quint64 useClock = 0;
+};
+thread_local DecodeCache t_cache;
+
+std::atomic<quint64> g_nextStoreId{ 1 };
+
+// 功率的预测值：V (V) * I (mA) = P (mW)
+// 两个 NaN 相乘得到哪个载荷取决于操作数顺序 / 是否向量化，编码和解码两边可能不同，NaN 一律预测成 0
+void predictPower(const float* v, const float* i, float* out, int n) {
+    for (int j = 0; j < n; ++j) {
+        const double p = double(v[j]) * double(i[j]);
+        out[j] = (p == p) ? float(p) : 0.0f;
+    }
+}
+
+// 解码子块 b 的第 s 列；按预测编码的功率要用同一子块已解出的 v / i
+void decodeSub(const Header* h, const quint64* words, int s, int b, float* out, const float* v, const float* i) {
+    BitReader r(words, h->bitPos[s][b]);
+    const quint8 mode = h->mode[s][b];
+    if (mode >= Header::kScaled) {
+        decodeScaled(r, out, Header::kSub, mode - Header::kScaled);
+    } else if (mode == Header::kPredicted) {
+        float pred[Header::kSub];
+        predictPower(v, i, pred, Header::kSub);
+        decodePredicted(r, pred, out, Header::kSub);
+    } else {
+        decodeFloats(r, out, Header::kSub);
+    }
+}
+
+// 一个子块的一列：能用的编码各试一遍，用最短的写入 w
+quint8 encodeSub(BitWriter& w, const float* v, const float* pred, std::vector<quint64>& trial) {
+    auto cost = [&](auto&& encode) {
+        trial.clear();
+        BitWriter t(trial);
+        encode(t);
+        return t.bitPos();
+    };
+
+    quint8 best = Header::kXor;
+    quint64 bestBits = cost([&](BitWriter& t) { encodeFloats(t, v, Header::kSub); });
+    if (pred) {
+        const quint64 bits = cost([&](BitWriter& t) { encodePredicted(t, v, pred, Header::kSub); });
+        if (bits < bestBits) { best = Header::kPredicted; bestBits = bits; }
+    }
+    const int scale = findScale(v, Header::kSub);
+    if (scale >= 0) {
+        const quint64 bits = cost([&](BitWriter& t) { encodeScaled(t, v, Header::kSub, scale); });
+        if (bits < bestBits) { best = quint8(Header::kScaled + scale); bestBits = bits; }
+    }
+
+    if (best >= Header::kScaled) encodeScaled(w, v, Header::kSub, best - Header::kScaled);
+    else if (best == Header::kPredicted) encodePredicted(w, v, pred, Header::kSub);
+    else encodeFloats(w, v, Header::kSub);
+    return best;
+}
+
+} // namespace
+
+// 落盘文件上的一个映射区，由索引项共同持有，最后一个引用放掉时解除映射
+struct ColdRegion {
+    QFile file;
+    uchar* map = nullptr;
+    qint64 start = 0; // 在文件里的范围
+    qint64 size = 0;
+    std::shared_ptr<void> lease;
+
+    ~ColdRegion() {
+        if (map) file.unmap(map);
+    }
+};
+
+const Header* ColdMapping::header(quint64 idx) const {
+    if (idx < m_first || idx >= m_end) return nullptr;
+    const quint64 seg = (idx - m_index->base) / Header::kSize;
+    return (*m_index->blocks[size_t(seg / ColdIndex::kBlock)])[size_t(seg % ColdIndex::kBlock)].header;
+}
+
+const DecodedSegment* ColdMapping::decoded(quint64 idx) const {
+    const Header* h = header(idx);
+    if (!h) return nullptr;
+
+    DecodeCache& cache = t_cache;
+    DecodedSegment* victim = nullptr;
+    for (auto& c : cache.entries[m_storeId % DecodeCache::kSets]) {
+        if (c && c->store == m_storeId && c->first == h->first) {
+            c->lastUse = ++cache.useClock;
+            return c.get();
+        }
+        if (!c) c = std::make_unique<DecodedSegment>();
+        if (!victim || c->lastUse < victim->lastUse) victim = c.get();
+    }
+
+    // 解码整段
+    const quint64* words = payload(h);
+    quint32 off[Header::kSub];
+    for (int b = 0; b < Header::kSubCount; ++b) {
+        const int k = b * Header::kSub;
+        const float* v = victim->col[int(Series::V)] + k;
+        const float* i = victim->col[int(Series::I)] + k;
+        for (int s = 0; s < kSeriesCount; ++s) decodeSub(h, words, s, b, victim->col[s] + k, v, i); // V、I 在 P 之前
+        BitReader r(words, h->bitPos[kSeriesCount][b]);
+        decodeOffsets(r, off, Header::kSub);
+        const TimeBlock& tb = h->blocks[b];
+        for (int j = 0; j < Header::kSub; ++j) victim->t[k + j] = tb.base + (quint64(off[j]) << tb.shift);
+    }
+    victim->store = m_storeId;
+    victim->first = h->first;
+    victim->lastUse = ++cache.useClock;
+    return victim;
+}
+
+float ColdMapping::value(Series s, quint64 idx) const {
+    const DecodedSegment* d = decoded(idx);
+    return d ? d->col[int(s)][idx - d->first] : 0.0f;
+}
+
+quint64 ColdMapping::time(quint64 idx) const {
+    const DecodedSegment* d = decoded(idx);
+    return d ? d->t[idx - d->first] : 0;
+}
+
+const float* ColdMapping::chunk(Series s, quint64 idx, int& n) const {
+    const DecodedSegment* d = decoded(idx);
+    if (!d) return nullptr;
+    const int k = int(idx - d->first);
+    n = Header::kSize - k;
+    return d->col[int(s)] + k;
+}
+
+void ColdMapping::aggregate(quint64 from, quint64 to, int s0, int s1, SeriesAgg* out) const {
+    float buf[kSeriesCount][Header::kSub];
+
+    while (from < to) {
+        const Header* h = header(from);
+        if (!h) break;
+
+        const quint64 segEnd = h->first + Header::kSize;
+        const quint64 stop = qMin(to, segEnd);
+        if (from == h->first && stop == segEnd) {
+            for (int s = s0; s < s1; ++s) out[s - s0].merge(h->total[s]); // 整段，不用解码
+            from = stop;
+            continue;
+        }
+
+        while (from < stop) {
+            const int k = int(from - h->first);
+            const int b = k / Header::kSub;
+            const int subStart = b * Header::kSub;
+            if (k == subStart && from + Header::kSub <= stop) {
+                for (int s = s0; s < s1; ++s) out[s - s0].merge(h->sub[s][b], Header::kSub);
+                from += Header::kSub;
+                continue;
+            }
+
+            // 子块的一部分：只解码这个子块（按预测编码的功率连带解出 V、I）
+            const int last = int(qMin<quint64>(stop - h->first, quint64(subStart + Header::kSub)));
+            const float* v = buf[int(Series::V)];
+            const float* i = buf[int(Series::I)];
+            const int P = int(Series::P);
+            const bool needVI = s1 > P && h->mode[P][b] == Header::kPredicted;
+            for (int s = 0; s < kSeriesCount; ++s) {
+                if ((s >= s0 && s < s1) || (needVI && s != P)) decodeSub(h, payload(h), s, b, buf[s], v, i);
+            }
+            for (int s = s0; s < s1; ++s) out[s - s0].add(buf[s] + (k - subStart), last - k);
+            from = h->first + quint64(last);
+        }
+    }
+}
+
+ColdStore::ColdStore(const QString& path)
+    : m_file(path), m_id(g_nextStoreId.fetch_add(1)), m_index(std::make_shared<ColdIndex>()),
+      m_lease(std::make_shared<int>(0)), m_encHeader(std::make_unique<Header>()) {}
+
+ColdStore::ColdStore(qint64 memoryBudget)
+    : m_id(g_nextStoreId.fetch_add(1)), m_budget(qMax<qint64>(1, memoryBudget)),
+      m_index(std::make_shared<ColdIndex>()), m_lease(std::make_shared<int>(0)),
+      m_encHeader(std::make_unique<Header>()) {}
+
+ColdStore::~ColdStore() {
+    if (!onDisk()) return;
+    m_index.reset();
+    m_region.reset();
+    m_file.close();
+    m_file.remove(); // 还被快照映射着时 Windows 上删不掉，交给临时目录清理
+}
+
+bool ColdStore::open() {
+    return !onDisk() || m_file.open(QIODevice::ReadWrite | QIODevice::Truncate);
+}
+
+void ColdStore::reset(quint64 first) {
+    // 旧映射继续用旧索引；写入方自己先放掉对映射区的引用
+    m_index = std::make_shared<ColdIndex>();
+    m_index->base = first;
+    m_region.reset();
+    // 没有映射区活着才截断（Windows 上映射期间不能截断）；否则接着往后写，旧段留在文件里
+    if (onDisk() && m_lease.use_count() == 1 && m_file.resize(0)) m_fileSize = 0;
+    m_first = first;
+    m_count = 0;
+    m_payloadBytes = 0;
+    m_storedBytes = 0;
+}
+
+const Header* ColdStore::segment(quint64 k) const {
+    const quint64 seg = (m_first - m_index->base) / Header::kSize + k;
+    return (*m_index->blocks[size_t(seg / ColdIndex::kBlock)])[size_t(seg % ColdIndex::kBlock)].header;
+}
+
+void ColdStore::addSegment(const Header* h, std::shared_ptr<const void> owner) {
+    const quint64 seg = (end() - m_index->base) / Header::kSize;
+    if (seg / ColdIndex::kBlock >= m_index->blocks.size()) {
+        // 目录已经发布给映射了就复制一份再加块；块本身共用
+        if (m_index.use_count() > 1) m_index = std::make_shared<ColdIndex>(*m_index);
+        m_index->blocks.push_back(std::make_shared<ColdIndex::Block>());
+    }
+    (*m_index->blocks[size_t(seg / ColdIndex::kBlock)])[size_t(seg % ColdIndex::kBlock)] = { h, std::move(owner) };
+    ++m_count;
+}
+
+void ColdStore::evictFront() {
+    const quint64 bytes = sizeof(Header) + segment(0)->words * sizeof(quint64);
+    m_storedBytes -= bytes;
+    m_payloadBytes -= bytes - sizeof(Header);
+    m_first += Header::kSize;
+    --m_count;
+
+    constexpr quint64 kBlockSamples = quint64(ColdIndex::kBlock) * Header::kSize;
+    if (m_first - m_index->base >= kBlockSamples) {
+        if (m_index.use_count() > 1) m_index = std::make_shared<ColdIndex>(*m_index);
+        m_index->blocks.erase(m_index->blocks.begin());
+        m_index->base += kBlockSamples;
+    }
+}
+
+bool ColdStore::openRegion(qint64 bytes) {
+    m_region.reset();
+    const qint64 start = m_fileSize;
+    const qint64 size = qMax(kRegionBytes, bytes);
+    // 先把文件加长到区域末尾，整个区域映射一次，之后写进来的段直接可读
+    if (!m_file.resize(start + size)) return false;
+
+    auto region = std::make_shared<ColdRegion>();
+    region->file.setFileName(m_file.fileName());
+    if (!region->file.open(QIODevice::ReadOnly)) return false;
+    region->map = region->file.map(start, size);
+    if (!region->map) return false;
+    region->start = start;
+    region->size = size;
+    region->lease = m_lease;
+    m_region = std::move(region);
+    return true;
+}
+
+quint64 ColdStore::evictCount() const {
+    if (onDisk()) return 0;
+    // 留出下一段的位置（按上一段的大小估计），淘汰到放得下为止
+    quint64 n = 0, bytes = m_storedBytes;
+    while (n < m_count && bytes + m_lastSegmentBytes > quint64(m_budget)) {
+        bytes -= sizeof(Header) + segment(n)->words * sizeof(quint64);
+        ++n;
+    }
+    return n;
+}
+
+quint64 ColdStore::beginAfterAppend() const {
+    return m_first + evictCount() * Header::kSize;
+}
+
+bool ColdStore::append(const HotChunk& chunk) {
+    Header& h = *m_encHeader;
+    m_encWords.clear();
+    BitWriter w(m_encWords);
+
+    float pred[Header::kSub];
+    for (int b = 0; b < Header::kSubCount; ++b) {
+        const int k = b * Header::kSub;
+        predictPower(chunk.col[int(Series::V)] + k, chunk.col[int(Series::I)] + k, pred, Header::kSub);
+        for (int s = 0; s < kSeriesCount; ++s) {
+            h.bitPos[s][b] = quint32(w.bitPos());
+            h.mode[s][b] = encodeSub(w, chunk.col[s] + k, s == int(Series::P) ? pred : nullptr, m_trialWords);
+        }
+        h.bitPos[kSeriesCount][b] = quint32(w.bitPos());
+        encodeOffsets(w, chunk.off + k, Header::kSub);
+    }
+    w.flush();
+
+    h.first = chunk.first;
+    h.words = m_encWords.size();
+    for (int s = 0; s < kSeriesCount; ++s) {
+        h.total[s] = chunk.total(Series(s));
+        for (int b = 0; b < Header::kSubCount; ++b) h.sub[s][b] = chunk.bucket(Series(s), 0, b * Header::kSub); // 第 0 层桶 = 子块
+    }
+    std::copy(std::begin(chunk.blocks), std::end(chunk.blocks), h.blocks);
+
+    const qint64 payload = qint64(m_encWords.size() * sizeof(quint64));
+    const quint64 segmentBytes = sizeof(Header) + quint64(payload);
+    // 段头和位流紧挨着，段头按 8 字节对齐，段的长度也是 8 的倍数
+    static_assert(sizeof(Header) % sizeof(quint64) == 0, "header must keep the payload aligned");
+    if (onDisk()) {
+        // 放不进当前映射区就新开一个，段不跨区域；跳过的尾巴留空
+        if (!m_region || m_fileSize + qint64(segmentBytes) > m_region->start + m_region->size) {
+            if (!openRegion(qint64(segmentBytes))) return false;
+        }
+        if (!m_file.seek(m_fileSize)) return false;
+        if (m_file.write(reinterpret_cast<const char*>(&h), sizeof(Header)) != qint64(sizeof(Header))) return false;
+        if (m_file.write(reinterpret_cast<const char*>(m_encWords.data()), payload) != payload) return false;
+        if (!m_file.flush()) return false;
+        const uchar* at = m_region->map + (m_fileSize - m_region->start);
+        addSegment(reinterpret_cast<const Header*>(at), m_region);
+        m_fileSize += qint64(segmentBytes);
+    } else {
+        for (quint64 n = evictCount(); n > 0; --n) evictFront();
+        auto buf = std::make_shared<std::vector<quint64>>(sizeof(Header) / sizeof(quint64) + m_encWords.size());
+        std::memcpy(buf->data(), &h, sizeof(Header));
+        std::copy(m_encWords.begin(), m_encWords.end(), buf->begin() + sizeof(Header) / sizeof(quint64));
+        const Header* at = reinterpret_cast<const Header*>(buf->data());
+        addSegment(at, std::move(buf));
+    }
+
+    m_payloadBytes += quint64(payload);
+    m_storedBytes += segmentBytes;
+    m_lastSegmentBytes = segmentBytes;
+    return true;
+}
+
+std::shared_ptr<const ColdMapping> ColdStore::mapping() const {
+    if (m_count == 0) return nullptr;
+
+    std::shared_ptr<ColdMapping> m(new ColdMapping);
+    m->m_storeId = m_id;
+    m->m_first = m_first;
+    m->m_end = end();
+    m->m_index = m_index;
+    return m;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <QFile>
+#include <array>
+#include <memory>
+#include <vector>
+#include "samplestore.h"
+
+// 压缩段格式：每段一个段头，后面紧跟位流
+struct ColdSegmentHeader {
+    static constexpr int kSize = HotChunk::kSize;
+    static constexpr int kSub = HotChunk::kBlock;      // 段内子块 = 时间戳块
+    static constexpr int kSubCount = kSize / kSub;
+
+    // 子块每列的编码，见 XorCodec；编码时三种都试，取最短的
+    static constexpr quint8 kXor = 0;                  // 与前一个值 XOR
+    static constexpr quint8 kPredicted = 1;            // 与 V * I 的预测值 XOR，只用于功率
+    static constexpr quint8 kScaled = 2;               // kScaled + 刻度序号：寄存器刻度差分打包
+
+    quint64 first;
+    quint64 words;                                              // 位流长度 (64 位字)
+    SeriesAgg total[kSeriesCount];
+    // 和用 double：窗口统计按子块重新求和时不丢精度
+    BucketAgg sub[kSeriesCount][kSubCount];
+    TimeBlock blocks[kSubCount];
+    quint32 bitPos[kSeriesCount + 1][kSubCount];                // 第 kSeriesCount 列为时间偏移
+    quint8 mode[kSeriesCount][kSubCount];
+};
+
+struct DecodedSegment;
+
+// 段索引里的一项：段头地址，以及段所在内存的所有者（落盘时是一个映射区，不落盘时是段自己的缓冲）
+struct ColdSegmentRef {
+    const ColdSegmentHeader* header = nullptr;
+    std::shared_ptr<const void> owner;
+};
+
+// 段索引：固定大小的块，只往后追加。写入方只填还没有映射看得到的项，
+// 已发布的项不再改动，所以新旧映射可以共用同一批块；目录只在加块 / 丢块时复制一次。
+struct ColdIndex {
+    static constexpr int kBlock = 32;
+    using Block = std::array<ColdSegmentRef, kBlock>;
+
+    quint64 base = 0;                          // blocks[0][0] 那一段的首个逻辑下标
+    std::vector<std::shared_ptr<Block>> blocks;
+};
+
+// 某一时刻压缩段的只读映射，不可变
+//
+// 只是共享段索引上的一个区间 [begin, end)：写入方封了新段就生成一个新的映射，O(1)，
+// 不复制已有的段表，也不重新映射文件。段所在的内存（落盘时的映射区、不落盘时的段缓冲）
+// 由索引项持有，读者手里的指针不会被换掉，内存里淘汰掉的段也等最后一个映射释放时才回收。
+// 随机访问 (滚动/逐点绘制) 走每线程一份、按 store 分组的已解码段缓存。
+class ColdMapping {
+public:
+    quint64 begin() const { return m_first; }
+    quint64 end() const { return m_end; }
+
+    // idx 须在 [begin(), end()) 内；读取失败返回 0 / nullptr
+    float value(Series s, quint64 idx) const;
+    quint64 time(quint64 idx) const;
+    // 从 idx 开始到段尾的连续一段，n 返回样本数；指针在本线程下一次解码之前有效
+    const float* chunk(Series s, quint64 idx, int& n) const;
+
+    // 列 [s0, s1) 在 [from, to) 上的聚合并入 out[0 .. s1 - s0)；整段 / 整子块直接用段头，不解码
+    void aggregate(quint64 from, quint64 to, int s0, int s1, SeriesAgg* out) const;
+
+private:
+    friend class ColdStore;
+
+    ColdMapping() = default;
+    const ColdSegmentHeader* header(quint64 idx) const;
+    const quint64* payload(const ColdSegmentHeader* h) const { return reinterpret_cast<const quint64*>(h + 1); }
+    const DecodedSegment* decoded(quint64 idx) const;
+
+    quint64 m_storeId = 0;                  // 解码缓存的键：(m_storeId, 段首下标) 全局唯一
+    quint64 m_first = 0;
+    quint64 m_end = 0;
+    std::shared_ptr<const ColdIndex> m_index;
+};
+
+struct ColdRegion;
+
+// 一个通道的压缩历史（写入方）
+//
+// 每段压缩后顺序追加：V / I / P 每个子块在三种编码里选最短的 —— 寄存器刻度上的差分定宽打包
+// (传感器读数是 整数 × LSB)、功率与 V * I 的预测值 XOR、Gorilla 式与前值 XOR；时间偏移用二阶差分。
+// 每 64 个样本重新起一段位流，所以可以只解码需要的子块。段头里的整段/子块聚合不压缩，
+// 大范围聚合不用解码。读取走 mapping()。
+//
+// 两种存放方式：
+//   落盘 (path)     追加到一个文件，由系统页缓存管理，进程内存不随会话时长增长。
+//                   文件按固定大小的区域预先加长、每个区域只映射一次，段不跨区域
+//   内存 (budget)   每段一块内存，总量超出预算时淘汰最旧的段；落盘不可用时的退路。
+//                   淘汰的段在整个索引块都淘汰后才回收
+class ColdStore {
+public:
+    explicit ColdStore(const QString& path);
+    explicit ColdStore(qint64 memoryBudget);
+    ~ColdStore();
+
+    bool open();
+    QString errorString() const { return m_file.errorString(); }
+    bool onDisk() const { return m_budget == 0; }
+
+    // 清空，下一段从逻辑下标 first 开始
+    void reset(quint64 first);
+    bool append(const HotChunk& chunk);
+
+    quint64 begin() const { return m_first; }
+    quint64 end() const { return m_first + m_count * ColdSegmentHeader::kSize; }
+    // 下一次 append 之后 begin() 的值：内存方式按预算先淘汰最旧的段
+    quint64 beginAfterAppend() const;
+
+    // 压缩后的总字节数（不含段头）
+    quint64 payloadBytes() const { return m_payloadBytes; }
+    // 现有各段占用的字节数，含段头
+    quint64 storedBytes() const { return m_storedBytes; }
+
+    // 当前已写入的全部段；没有段时返回空
+    std::shared_ptr<const ColdMapping> mapping() const;
+
+private:
+    static constexpr qint64 kRegionBytes = qint64(8) << 20;
+
+    // 按预算要淘汰的最旧段数
+    quint64 evictCount() const;
+    // 从 begin() 数起第 k 段
+    const ColdSegmentHeader* segment(quint64 k) const;
+    // 把一段登记到索引末尾
+    void addSegment(const ColdSegmentHeader* h, std::shared_ptr<const void> owner);
+    // 淘汰最旧的一段；整块都淘汰了就从目录里拿掉
+    void evictFront();
+    // 从 m_fileSize 起新开一个至少 bytes 字节的映射区
+    bool openRegion(qint64 bytes);
+
+    QFile m_file;
+    const quint64 m_id;
+    const qint64 m_budget = 0;                // 0 = 落盘
+    quint64 m_first = 0;
+    quint64 m_count = 0;
+    std::shared_ptr<ColdIndex> m_index;       // 与已发布的映射共用
+    std::shared_ptr<ColdRegion> m_region;     // 落盘：正在写的映射区
+    qint64 m_fileSize = 0;                    // 下一段写入的位置
+    quint64 m_payloadBytes = 0;
+    quint64 m_storedBytes = 0;
+    quint64 m_lastSegmentBytes = 0;
+    std::shared_ptr<void> m_lease;            // 映射区各持一份，还有映射区活着时不截断文件
+
+    std::vector<quint64> m_encWords;          // append 用的暂存
+    std::vector<quint64> m_trialWords;        // 试编码
+    std::unique_ptr<ColdSegmentHeader> m_encHeader;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <QtGlobal>
+#include <cmath>
+#include <initializer_list>
+
+// Neumaier 补偿求和：几天里累加上亿个很小的增量，误差不随次数增长
+struct KahanSum {
+    double sum = 0.0;
+    double c = 0.0;
+
+    void add(double x) {
+        const double t = sum + x;
+        if (std::abs(sum) >= std::abs(x)) c += (sum - t) + x;
+        else c += (x - t) + sum;
+        sum = t;
+    }
+    double value() const { return sum + c; }
+    void reset() { sum = c = 0.0; }
+};
+
+// 一个通道的累计能量 (mWh) / 电荷 (mAh)
+// 在 ingest 时对相邻样本做梯形积分，不依赖历史缓冲，清空波形、历史被覆盖都不影响。
+// 两组累计：连接以来、用户复位以来。
+class EnergyMeter {
+public:
+    // 相邻样本间隔超过这个值视为断流（暂停/丢包），这一段不积分
+    static constexpr quint64 kMaxGapNs = 5ULL * 1000000000ULL;
+
+    struct Total {
+        KahanSum e;       // mW * ns
+        KahanSum q;       // mA * ns
+        quint64 ns = 0;   // 积分覆盖的时长
+
+        double mWh() const { return e.value() / 3.6e12; }
+        double mAh() const { return q.value() / 3.6e12; }
+        void reset() { e.reset(); q.reset(); ns = 0; }
+    };
+
+    void add(float i_mA, float p_mW, quint64 t_ns) {
+        if (m_hasLast && t_ns > m_lastT && t_ns - m_lastT <= kMaxGapNs) {
+            const double dt = double(t_ns - m_lastT);
+            const double de = (double(m_lastP) + p_mW) / 2.0 * dt;
+            const double dq = (double(m_lastI) + i_mA) / 2.0 * dt;
+            for (Total* t : { &m_connect, &m_user }) {
+                t->e.add(de);
+                t->q.add(dq);
+                t->ns += t_ns - m_lastT;
+            }
+        }
+        m_hasLast = true;
+        m_lastT = t_ns;
+        m_lastI = i_mA;
+        m_lastP = p_mW;
+    }
+
+    // 设备重新连接：连接累计清零，断开期间不积分
+    void resetConnect() { m_connect.reset(); m_hasLast = false; }
+    // 用户复位点
+    void resetUser() { m_user.reset(); }
+
+    const Total& sinceConnect() const { return m_connect; }
+    const Total& sinceReset() const { return m_user; }
+
+private:
+    Total m_connect;
+    Total m_user;
+    bool m_hasLast = false;
+    quint64 m_lastT = 0;
+    float m_lastI = 0.0f;
+    float m_lastP = 0.0f;
+};
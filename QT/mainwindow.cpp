@@ -7,20 +7,22 @@
 #include <QTextStream>
 #include <QSerialPortInfo>
 #include <QThread>
+#include <QThreadPool>
+#include <QPointer>
 #include <QElapsedTimer>
 #include <cmath>
-#include <limits>
 
-static constexpr int kMaxChannels = 6;
-static QColor kChColorsV[kMaxChannels] = {
+// 通道配色，超过 6 个通道循环使用
+static constexpr int kPaletteSize = 6;
+static QColor kChColorsV[kPaletteSize] = {
     QColor("#fdd835"), QColor("#00e5ff"), QColor("#66bb6a"),
     QColor("#ab47bc"), QColor("#ffa726"), QColor("#ef5350")
 };
-static QColor kChColorsI[kMaxChannels] = {
+static QColor kChColorsI[kPaletteSize] = {
     QColor("#ff9800"), QColor("#2979ff"), QColor("#43a047"),
     QColor("#7e57c2"), QColor("#fb8c00"), QColor("#e53935")
 };
-static QColor kChColorsP[kMaxChannels] = {
+static QColor kChColorsP[kPaletteSize] = {
     QColor("#ff5252"), QColor("#d05ce3"), QColor("#26c6da"),
     QColor("#ec407a"), QColor("#ffd54f"), QColor("#8d6e63")
 };
@@ -28,35 +30,23 @@ static QColor kChColorsP[kMaxChannels] = {
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     m_clock = new QElapsedTimer();
     m_clock->start();
+    m_t0Ns = monotonicNs();
 
     setupUI();
 
-    // ---- Serial worker thread
+    // ---- Serial worker threads: 连接设备时按需创建
     qRegisterMetaType<ParsedSample>("ParsedSample");
 
-    ioThread = new QThread(this);
-    worker = new SerialWorker();
-    worker->moveToThread(ioThread);
-
-    connect(ioThread, &QThread::finished, worker, &QObject::deleteLater);
-
-    connect(worker, &SerialWorker::sampleReady, this, &MainWindow::onSampleReady, Qt::QueuedConnection);
-    connect(worker, &SerialWorker::logLine, this, [this](const QString& s){
-        // 低频日志：只显示重要行
-        logWindow->append(s.toHtmlEscaped());
-    }, Qt::QueuedConnection);
-    connect(worker, &SerialWorker::errorOccured, this, [this](const QString& s){
-        QMessageBox::critical(this, "串口错误", s);
-    }, Qt::QueuedConnection);
-
-    ioThread->start();
-
     // ---- UI refresh timer (30fps)
     auto *timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, &MainWindow::refreshUI);
     timer->start(33);
 }
 
+MainWindow::~MainWindow() {
+    while (!m_devices.empty()) disconnectDevice(int(m_devices.size()) - 1);
+}
+
 bool MainWindow::eventFilter(QObject* watched, QEvent* event) {
     if (event->type() == QEvent::MouseButtonPress) {
         // 尝试从 watched 或其 parent 链上找 chIndex
@@ -99,6 +89,10 @@ void MainWindow::setupUI() {
 
     portSelector = new QComboBox(this);
     portSelector->setFixedWidth(220);
+    // 也可直接输入数据源：file:<path>?rate=<B/s> / pty: / pty:<path> / tcp:<host>:<port>
+    portSelector->setEditable(true);
+    portSelector->setInsertPolicy(QComboBox::NoInsert);
+    portSelector->setToolTip("串口，或 file:<路径>?rate=<B/s>&loop=1 / pty: / pty:<路径> / tcp:<主机>:<端口>");
 
     btnConnect = new QPushButton("连接设备", this);
     btnConnect->setStyleSheet("background-color: #00e676; color: #000;");
@@ -123,42 +117,20 @@ void MainWindow::setupUI() {
     // Left: tabs (Overview / Focus)
     m_tabs = new QTabWidget(this);
 
-    // ---- Overview tab
-    QWidget* overviewPage = new QWidget(this);
-    auto *overviewGrid = new QGridLayout(overviewPage);
-    overviewGrid->setContentsMargins(8, 8, 8, 8);
-    overviewGrid->setHorizontalSpacing(10);
-    overviewGrid->setVerticalSpacing(10);
-
-    for (int i = 0; i < kMaxChannels; ++i) {
-        auto *cell = new QWidget(this);
-        auto *cellLayout = new QVBoxLayout(cell);
-        cellLayout->setContentsMargins(0,0,0,0);
-        cellLayout->setSpacing(4);
-
-        auto *title = new QLabel(QString("CHANNEL %1").arg(i+1), this);
-        title->setStyleSheet("font-weight:bold; color:#bdbdbd;");
-        title->setProperty("chIndex", i);
-        title->installEventFilter(this);
-        cellLayout->addWidget(title, 0, Qt::AlignLeft);
-
-        m_overviewScopes[i] = new Oscilloscope(kChColorsV[i], kChColorsI[i], kChColorsP[i], this);
-        m_overviewScopes[i]->setMinimumHeight(160);
-        m_overviewScopes[i]->setProperty("chIndex", i);
-        m_overviewScopes[i]->installEventFilter(this);
-        cell->setProperty("chIndex", i);
-        cell->installEventFilter(this);
-
-        cellLayout->addWidget(m_overviewScopes[i], 1);
+    // ---- Overview tab: 通道收到第一个样本时才加入网格 (ensureChannelUI)
+    auto *overviewScroll = new QScrollArea(this);
+    overviewScroll->setWidgetResizable(true);
+    overviewScroll->setFrameShape(QFrame::NoFrame);
 
+    QWidget* overviewPage = new QWidget(this);
+    m_overviewGrid = new QGridLayout(overviewPage);
+    m_overviewGrid->setContentsMargins(8, 8, 8, 8);
+    m_overviewGrid->setHorizontalSpacing(10);
+    m_overviewGrid->setVerticalSpacing(10);
+    m_overviewGrid->setAlignment(Qt::AlignTop);
+    overviewScroll->setWidget(overviewPage);
 
-
-        int row = i / 2; // 3 rows, 2 cols
-        int col = i % 2;
-        overviewGrid->addWidget(cell, row, col);
-    }
-
-    m_tabs->addTab(overviewPage, "Overview");
+    m_tabs->addTab(overviewScroll, "Overview");
 
     // ---- Focus tab
     QWidget* focusPage = new QWidget(this);
@@ -167,12 +139,24 @@ void MainWindow::setupUI() {
 
     m_focusScope = new Oscilloscope(kChColorsV[0], kChColorsI[0], kChColorsP[0], this);
     focusLayout->addWidget(m_focusScope, 1);
+    m_focusSlot = m_scheduler.add(m_focusScope, RenderScheduler::Tier::Focus, [this]{
+        if (m_trigger.enabled() && !m_capture.empty()) {
+            // 触发采集到的窗口：写入方继续写、块退役都不影响这份快照
+            m_focusScope->setData(m_capture, 0, zoom);
+            m_focusScope->setMarker(m_captureMarker);
+            if (m_captureNew) m_focusScope->fitToView();
+            m_captureNew = false;
+        } else {
+            m_focusScope->setData(m_bufs[m_selectedCh].view(), offset, zoom);
+            m_focusScope->setMarker(-1);
+        }
+    });
 
     auto *bottomBar = new QHBoxLayout();
     slider = new QSlider(Qt::Horizontal, this);
     slider->setRange(0, 0);
     connect(slider, &QSlider::valueChanged, this, [this](int v){
-        offset = v;
+        offset = qint64(v) * m_sliderStep;
         dirty = true;
     });
 
@@ -180,6 +164,66 @@ void MainWindow::setupUI() {
     bottomBar->addWidget(slider, 1);
     focusLayout->addLayout(bottomBar);
 
+    // ---- 触发：Focus 通道每个样本都判断，采到的窗口冻结显示在上面
+    auto *trigBar = new QHBoxLayout();
+    m_trigMode = new QComboBox(this);
+    m_trigMode->addItems({"关闭", "自动", "正常", "单次"}); // 与 TriggerConfig::Mode 顺序一致
+    m_trigSource = new QComboBox(this);
+    m_trigSource->addItems({"V", "I", "P"});
+    m_trigSource->setCurrentIndex(1);
+    m_trigType = new QComboBox(this);
+    m_trigType->addItems({"上升沿", "下降沿", "高于电平", "低于电平", "正脉宽", "负脉宽"});
+    m_trigLevel = new QDoubleSpinBox(this);
+    m_trigLevel->setRange(-1e6, 1e6);
+    m_trigLevel->setDecimals(3);
+    m_trigLevel->setToolTip("触发电平（V / mA / mW）");
+    m_trigWidthMin = new QDoubleSpinBox(this);
+    m_trigWidthMax = new QDoubleSpinBox(this);
+    for (QDoubleSpinBox* w : { m_trigWidthMin, m_trigWidthMax }) {
+        w->setRange(0, 1e6);
+        w->setDecimals(3);
+        w->setSuffix(" ms");
+    }
+    m_trigWidthMin->setToolTip("脉宽下限，0 不限");
+    m_trigWidthMax->setToolTip("脉宽上限，0 不限");
+    m_trigPre = new QSpinBox(this);
+    m_trigPre->setRange(0, 10000000);
+    m_trigPre->setValue(1000);
+    m_trigPre->setPrefix("前 ");
+    m_trigPre->setToolTip("预触发样本数");
+    m_trigPost = new QSpinBox(this);
+    m_trigPost->setRange(1, 10000000);
+    m_trigPost->setValue(4000);
+    m_trigPost->setPrefix("后 ");
+    m_trigPost->setToolTip("触发点及之后的样本数");
+    auto *btnArm = new QPushButton("布防", this);
+    btnArm->setToolTip("重新等待触发（单次模式采完后使用）");
+    m_trigStatus = new QLabel("--", this);
+
+    for (QComboBox* w : { m_trigMode, m_trigSource, m_trigType })
+        connect(w, &QComboBox::currentIndexChanged, this, [this](int){ applyTrigger(); });
+    for (QDoubleSpinBox* w : { m_trigLevel, m_trigWidthMin, m_trigWidthMax })
+        connect(w, qOverload<double>(&QDoubleSpinBox::valueChanged), this, [this](double){ applyTrigger(); });
+    for (QSpinBox* w : { m_trigPre, m_trigPost })
+        connect(w, qOverload<int>(&QSpinBox::valueChanged), this, [this](int){ applyTrigger(); });
+    connect(btnArm, &QPushButton::clicked, this, [this]{
+        m_trigger.arm();
+        dirty = true;
+    });
+
+    trigBar->addWidget(new QLabel("触发", this));
+    trigBar->addWidget(m_trigMode);
+    trigBar->addWidget(m_trigSource);
+    trigBar->addWidget(m_trigType);
+    trigBar->addWidget(m_trigLevel);
+    trigBar->addWidget(m_trigWidthMin);
+    trigBar->addWidget(m_trigWidthMax);
+    trigBar->addWidget(m_trigPre);
+    trigBar->addWidget(m_trigPost);
+    trigBar->addWidget(btnArm);
+    trigBar->addWidget(m_trigStatus, 1);
+    focusLayout->addLayout(trigBar);
+
     m_tabs->addTab(focusPage, "Focus");
 
     // Right: side panel
@@ -195,48 +239,12 @@ void MainWindow::setupUI() {
     scroll->setFrameShape(QFrame::NoFrame);
 
     QWidget *cardsHost = new QWidget(this);
-    auto *cardsLayout = new QGridLayout(cardsHost);
-    cardsLayout->setContentsMargins(0,0,0,0);
-    cardsLayout->setHorizontalSpacing(8);
-    cardsLayout->setVerticalSpacing(8);
-
-    for (int i = 0; i < kMaxChannels; ++i) {
-        auto *card = new QGroupBox(QString("● CH%1").arg(i+1), this);
-        card->setStyleSheet(QString("QGroupBox { border-left: 3px solid %1; }")
-                                .arg(kChColorsV[i].name()));
-
-        auto *vbox = new QVBoxLayout(card);
-        vbox->setSpacing(2);
-
-        m_chV[i] = new QLabel("--.--- V", this);
-        m_chI[i] = new QLabel("--.-- mA", this);
-        m_chP[i] = new QLabel("--.-- mW", this);
-
-        // 字体小一点
-        m_chV[i]->setStyleSheet(QString("font-size: 15px; color: %1;").arg(kChColorsV[i].name()));
-        m_chI[i]->setStyleSheet(QString("font-size: 15px; color: %1;").arg(kChColorsI[i].name()));
-        m_chP[i]->setStyleSheet(QString("font-size: 15px; color: %1;").arg(kChColorsP[i].name()));
-
-        vbox->addWidget(m_chV[i]);
-        vbox->addWidget(m_chI[i]);
-        vbox->addWidget(m_chP[i]);
-
-        // Focus 按钮做成小图标/小按钮（可选）
-        auto *btnFocus = new QPushButton("Focus", this);
-        btnFocus->setFixedHeight(24);
-        connect(btnFocus, &QPushButton::clicked, this, [this, i](){
-            setSelectedChannel(i);
-            if (m_tabs) m_tabs->setCurrentIndex(1);
-        });
-        vbox->addWidget(btnFocus);
-
-        int row = i / 2;
-        int col = i % 2;
-        cardsLayout->addWidget(card, row, col);
-    }
-
+    m_cardsLayout = new QGridLayout(cardsHost);
+    m_cardsLayout->setContentsMargins(0,0,0,0);
+    m_cardsLayout->setHorizontalSpacing(8);
+    m_cardsLayout->setVerticalSpacing(8);
+    m_cardsLayout->setAlignment(Qt::AlignTop);
 
-    cardsLayout->setRowStretch(cardsLayout->rowCount(), 1);
     scroll->setWidget(cardsHost);
 
     sideLayout->addWidget(scroll, 3);
@@ -245,8 +253,7 @@ void MainWindow::setupUI() {
     auto *statsBox = new QGroupBox("统计（最近 N 秒）", this);
     auto *statsLayout = new QGridLayout(statsBox);
 
-    m_statsChSelector = new QComboBox(this);
-    for (int i = 0; i < kMaxChannels; ++i) m_statsChSelector->addItem(QString("CH%1").arg(i+1), i);
+    m_statsChSelector = new QComboBox(this); // 通道登记时追加
     connect(m_statsChSelector, &QComboBox::currentIndexChanged, this, [this](int){
     dirty = true;
 });
@@ -254,7 +261,10 @@ void MainWindow::setupUI() {
 m_statsWindowSec = new QSpinBox(this);
 m_statsWindowSec->setRange(1, 300);
 m_statsWindowSec->setValue(10);
-connect(m_statsWindowSec, qOverload<int>(&QSpinBox::valueChanged), this, [this](int){
+connect(m_statsWindowSec, qOverload<int>(&QSpinBox::valueChanged), this, [this](int sec){
+    // 窗口长度变了：各通道从现有历史重建一次，之后继续增量更新
+    for (int ch = 0; ch < m_registry.count(); ++ch)
+        m_stats[ch].setWindow((quint64)sec * 1000000000ULL, m_bufs[ch]);
     dirty = true;
 });
 
@@ -286,6 +296,25 @@ m_energyWh->setStyleSheet("font-weight:bold; color:#00e676;");
 statsLayout->addWidget(m_energyMWh, 5, 0, 1, 2);
 statsLayout->addWidget(m_energyWh, 5, 2, 1, 2);
 
+// Lifetime energy / charge：ingest 时积分，不受窗口和清空影响
+m_lifeConnect = new QLabel("--", this);
+m_lifeReset = new QLabel("--", this);
+m_lifeConnect->setStyleSheet("color:#4fc3f7;");
+m_lifeReset->setStyleSheet("color:#4fc3f7;");
+auto *btnResetLife = new QPushButton("复位", this);
+btnResetLife->setToolTip("将所选通道的“复位以来”累计清零");
+connect(btnResetLife, &QPushButton::clicked, this, [this]{
+    int chIndex = m_statsChSelector ? m_statsChSelector->currentData().toInt() : 0;
+    if (chIndex < 0 || chIndex >= kMaxChannels) return;
+    m_meters[chIndex].resetUser();
+    dirty = true;
+});
+statsLayout->addWidget(new QLabel("连接以来", this), 6, 0);
+statsLayout->addWidget(m_lifeConnect, 6, 1, 1, 4);
+statsLayout->addWidget(new QLabel("复位以来", this), 7, 0);
+statsLayout->addWidget(m_lifeReset, 7, 1, 1, 3);
+statsLayout->addWidget(btnResetLife, 7, 4);
+
 sideLayout->addWidget(statsBox, 0);
 
 // ---- Log window
@@ -317,9 +346,98 @@ mainBody->addWidget(sidePanel, 1);
 rootLayout->addLayout(mainBody);
 
 updatePortList();
+connect(portSelector, &QComboBox::currentTextChanged, this, [this](const QString&){
+    updateConnectButton();
+});
 setSelectedChannel(0);
 }
 
+void MainWindow::ensureChannelUI(int i) {
+    if (m_overviewScopes[i]) return;
+
+    const QString name = m_registry.label(i);
+    const QString source = m_registry.deviceName(m_registry.deviceOf(i));
+
+    // ---- 历史落盘：内存里只留最近一段，更早的样本压缩后写到临时目录
+    QString spillError = m_spillDir.errorString();
+    if (!m_spillDir.isValid() ||
+        !m_bufs[i].enableSpill(m_spillDir.filePath(QString("ch%1.seg").arg(i)), &spillError)) {
+        logWindow->append(QString("<font color='#ffa726'>[系统] %1 无法创建磁盘历史（%2），压缩后的历史留在内存里，最多 %3 MB</font>")
+                              .arg(name, spillError.toHtmlEscaped()).arg(SampleStore::kDefaultCompressedBytes >> 20));
+    }
+    m_stats[i].setWindow((quint64)m_statsWindowSec->value() * 1000000000ULL, m_bufs[i]);
+    const int pal = i % kPaletteSize;
+
+    // ---- Overview cell
+    auto *cell = new QWidget(this);
+    auto *cellLayout = new QVBoxLayout(cell);
+    cellLayout->setContentsMargins(0,0,0,0);
+    cellLayout->setSpacing(4);
+
+    auto *title = new QLabel(name, this);
+    title->setStyleSheet("font-weight:bold; color:#bdbdbd;");
+    title->setToolTip(source);
+    title->setProperty("chIndex", i);
+    title->installEventFilter(this);
+    cellLayout->addWidget(title, 0, Qt::AlignLeft);
+
+    m_overviewScopes[i] = new Oscilloscope(kChColorsV[pal], kChColorsI[pal], kChColorsP[pal], this);
+    m_overviewScopes[i]->setMinimumHeight(160);
+    m_overviewScopes[i]->setProperty("chIndex", i);
+    m_overviewScopes[i]->installEventFilter(this);
+    cell->setProperty("chIndex", i);
+    cell->installEventFilter(this);
+
+    cellLayout->addWidget(m_overviewScopes[i], 1);
+    m_overviewSlot[i] = m_scheduler.add(m_overviewScopes[i], RenderScheduler::Tier::Overview, [this, i]{
+        m_overviewScopes[i]->setData(m_bufs[i].view(), 0, zoom);
+    });
+
+    int row = i / 2; // 2 cols
+    int col = i % 2;
+    m_overviewGrid->addWidget(cell, row, col);
+
+    // ---- Channel card
+    auto *card = new QGroupBox("● " + name, this);
+    card->setToolTip(source);
+    card->setStyleSheet(QString("QGroupBox { border-left: 3px solid %1; }")
+                            .arg(kChColorsV[pal].name()));
+
+    auto *vbox = new QVBoxLayout(card);
+    vbox->setSpacing(2);
+
+    m_chV[i] = new QLabel("--.--- V", this);
+    m_chI[i] = new QLabel("--.-- mA", this);
+    m_chP[i] = new QLabel("--.-- mW", this);
+
+    // 字体小一点
+    m_chV[i]->setStyleSheet(QString("font-size: 15px; color: %1;").arg(kChColorsV[pal].name()));
+    m_chI[i]->setStyleSheet(QString("font-size: 15px; color: %1;").arg(kChColorsI[pal].name()));
+    m_chP[i]->setStyleSheet(QString("font-size: 15px; color: %1;").arg(kChColorsP[pal].name()));
+
+    vbox->addWidget(m_chV[i]);
+    vbox->addWidget(m_chI[i]);
+    vbox->addWidget(m_chP[i]);
+
+    auto *btnFocus = new QPushButton("Focus", this);
+    btnFocus->setFixedHeight(24);
+    connect(btnFocus, &QPushButton::clicked, this, [this, i](){
+        setSelectedChannel(i);
+        if (m_tabs) m_tabs->setCurrentIndex(1);
+    });
+    vbox->addWidget(btnFocus);
+
+    m_cardsLayout->addWidget(card, row, col);
+
+    // ---- Stats selector
+    m_statsChSelector->addItem(name, i);
+}
+
+void MainWindow::markAllChannelsDirty() {
+    m_chDirty.fill(true);
+    dirty = true;
+}
+
 void MainWindow::updatePortList() {
     QString current = portSelector->currentData().toString();
     portSelector->clear();
@@ -339,38 +457,110 @@ void MainWindow::updatePortList() {
     }
 }
 
-void MainWindow::toggleSerial() {
-    if (connected) {
-        QMetaObject::invokeMethod(worker, "closePort", Qt::QueuedConnection);
-        connected = false;
+QString MainWindow::selectedSpec() const {
+    // 列表项用端口名，手动输入的文本按数据源描述串处理
+    QString spec = portSelector->currentData().toString();
+    int cur = portSelector->currentIndex();
+    if (cur < 0 || portSelector->currentText() != portSelector->itemText(cur))
+        spec = portSelector->currentText().trimmed();
+    return spec;
+}
+
+int MainWindow::findDevice(const QString& spec) const {
+    for (int k = 0; k < (int)m_devices.size(); ++k)
+        if (m_devices[k].spec == spec) return k;
+    return -1;
+}
 
+void MainWindow::updateConnectButton() {
+    // 按钮针对当前选中的端口：已连接则显示断开
+    if (findDevice(selectedSpec()) >= 0) {
+        btnConnect->setText("断开连接");
+        btnConnect->setStyleSheet("background-color: #d32f2f; color: #fff;");
+    } else {
         btnConnect->setText("连接设备");
         btnConnect->setStyleSheet("background-color: #00e676; color: #000;");
-        portSelector->setEnabled(true);
-        logWindow->append("<font color='gray'>[系统] 已断开</font>");
+    }
+}
+
+void MainWindow::toggleSerial() {
+    QString spec = selectedSpec();
+    int dev = findDevice(spec);
+    if (dev >= 0) {
+        disconnectDevice(dev);
         return;
     }
 
-    QString portName = portSelector->currentData().toString();
-    if (portName.isEmpty()) {
+    if (spec.isEmpty()) {
         QMessageBox::warning(this, "错误", "未检测到可用串口！");
         return;
     }
+    connectDevice(spec);
+}
+
+void MainWindow::connectDevice(const QString& spec) {
+    Device d;
+    d.id = m_registry.deviceId(spec);
+    d.spec = spec;
 
-    QMetaObject::invokeMethod(worker, "openPort", Qt::QueuedConnection,
-                              Q_ARG(QString, portName),
+    // 同一设备重连：“连接以来”的累计从零开始
+    for (int ch = 0; ch < m_registry.count(); ++ch)
+        if (m_registry.deviceOf(ch) == d.id) m_meters[ch].resetConnect();
+    d.thread = new QThread(this);
+    d.worker = new SerialWorker();
+    d.worker->moveToThread(d.thread);
+
+    connect(d.thread, &QThread::finished, d.worker, &QObject::deleteLater);
+
+    SerialWorker* w = d.worker;
+    connect(w, &SerialWorker::logLine, this, [this](const QString& s){
+        // 低频日志：只显示重要行
+        logWindow->append(s.toHtmlEscaped());
+    }, Qt::QueuedConnection);
+    connect(w, &SerialWorker::errorOccured, this, [this](const QString& s){
+        QMessageBox::critical(this, "串口错误", s);
+    }, Qt::QueuedConnection);
+    connect(w, &SerialWorker::connectedChanged, this, [this, w](bool ok){
+        // 打开失败时移除该设备
+        if (ok) return;
+        for (int k = 0; k < (int)m_devices.size(); ++k)
+            if (m_devices[k].worker == w) { disconnectDevice(k); break; }
+    }, Qt::QueuedConnection);
+
+    d.thread->start();
+    QMetaObject::invokeMethod(w, "openSource", Qt::QueuedConnection,
+                              Q_ARG(QString, spec),
                               Q_ARG(int, 115200));
 
-    connected = true;
-    btnConnect->setText("断开连接");
-    btnConnect->setStyleSheet("background-color: #d32f2f; color: #fff;");
-    portSelector->setEnabled(false);
-    logWindow->append(QString("<font color='#00e676'>[系统] 连接至 %1</font>").arg(portName));
+    m_devices.push_back(d);
+    updateConnectButton();
+    logWindow->append(QString("<font color='#00e676'>[系统] 连接至 %1</font>").arg(spec.toHtmlEscaped()));
+}
+
+void MainWindow::disconnectDevice(int devIndex) {
+    if (devIndex < 0 || devIndex >= (int)m_devices.size()) return;
+
+    // 先取完队列里剩下的样本，之后 GUI 不再碰这个 worker
+    drainSamples();
+    Device d = m_devices[devIndex];
+    m_devices.erase(m_devices.begin() + devIndex);
+
+    // 等 IO 线程关闭数据源后再退出线程，finished -> worker deleteLater
+    QMetaObject::invokeMethod(d.worker, "closePort", Qt::BlockingQueuedConnection);
+    d.thread->quit();
+    d.thread->wait();
+    delete d.thread;
+
+    updateConnectButton();
+    logWindow->append(QString("<font color='gray'>[系统] 已断开 %1</font>").arg(d.spec.toHtmlEscaped()));
 }
 
 void MainWindow::setSelectedChannel(int chIndex) {
     if (chIndex < 0 || chIndex >= kMaxChannels) return;
+    if (chIndex >= m_registry.count() && m_registry.count() > 0) return;
     m_selectedCh = chIndex;
+    m_focusEnd = m_bufs[chIndex].end();
+    if (m_trigMode) applyTrigger(); // 触发跟着 Focus 通道走，换通道重新布防
 
     // update focus scope colors to match channel
     if (m_focusScope) {
@@ -383,177 +573,263 @@ void MainWindow::setSelectedChannel(int chIndex) {
     dirty = true;
 }
 
-void MainWindow::onSampleReady(const ParsedSample& s) {
-    int chIndex = s.ch - 1;
-    if (chIndex < 0 || chIndex >= kMaxChannels) return;
-
-    PowerData pt;
-    pt.v = s.v;
-    pt.i = s.i;
-    pt.p = s.p;
-    pt.t_ms = (quint64)m_clock->elapsed();
-
-    auto &buf = m_bufs[chIndex];
-    buf.push_back(pt);
-
-    // Batch trim
-    static const int kMax = 10000;
-    static const int kMargin = 2000;
-    if ((int)buf.size() > kMax + kMargin) {
-        buf.erase(buf.begin(), buf.end() - kMax);
+void MainWindow::drainSamples() {
+    // IO 线程只往各自的 ring 里写，这里每帧一次性取空
+    for (Device& d : m_devices) {
+        SampleRing& ring = d.worker->ring();
+        size_t n = ring.drain([this, &d](const ParsedSample& s) {
+            bool isNew = false;
+            int chIndex = m_registry.channelIndex(d.id, s.ch, &isNew);
+            if (chIndex < 0) return; // 超出 kMaxChannels
+            if (isNew) ensureChannelUI(chIndex);
+            ingestSample(chIndex, s);
+        });
+        if (n > 0) dirty = true;
+
+        // 溢出提示最多每秒一次
+        quint64 drops = ring.dropped();
+        if (drops != d.reportedDrops && m_clock->elapsed() - d.lastDropReportMs >= 1000) {
+            logWindow->append(QString("<font color='#ffa726'>[系统] %1 样本队列溢出：累计丢弃 %2 个（容量 %3，峰值 %4）</font>")
+                                  .arg(d.spec.toHtmlEscaped()).arg(drops).arg(ring.capacity()).arg(ring.highWater()));
+            d.reportedDrops = drops;
+            d.lastDropReportMs = m_clock->elapsed();
+        }
     }
 
-    // Update dashboard labels (latest value)
-    m_chV[chIndex]->setText(QString::number(pt.v, 'f', 3) + " V");
-    m_chI[chIndex]->setText(QString::number(pt.i, 'f', 1) + " mA");
-    m_chP[chIndex]->setText(QString::number(pt.p, 'f', 1) + " mW");
-
-    dirty = true;
-}
-
-static void computeStatsWindow(
-    const std::vector<PowerData>& buf,
-    quint64 windowMs,
-    double PowerData::*member,
-    double& outMin, double& outMax, double& outAvg, double& outRms)
-{
-    outMin = std::numeric_limits<double>::infinity();
-    outMax = -std::numeric_limits<double>::infinity();
-    outAvg = 0.0;
-    outRms = 0.0;
-
-    if (buf.empty()) return;
-
-    quint64 tEnd = buf.back().t_ms;
-    quint64 tStart = (tEnd > windowMs) ? (tEnd - windowMs) : 0;
-
-    double sum = 0.0, sumSq = 0.0;
-    int n = 0;
-
-    // scan from back until out of window (fast for recent window)
-    for (int idx = (int)buf.size() - 1; idx >= 0; --idx) {
-        if (buf[idx].t_ms < tStart) break;
-        double v = buf[idx].*member;
-        outMin = std::min(outMin, v);
-        outMax = std::max(outMax, v);
-        sum += v;
-        sumSq += v * v;
-        n++;
+    // 每批写完发布一次快照，示波器/导出只读快照
+    for (int ch = 0; ch < m_registry.count(); ++ch) {
+        if (m_chDirty[ch]) m_bufs[ch].publish();
     }
 
-    if (n == 0) return;
-    outAvg = sum / n;
-    outRms = std::sqrt(sumSq / n);
+    // 触发窗口收齐了：在刚发布的快照上冻结这一段，之后写入方退役/落盘都不影响它
+    TriggerCapture cap;
+    if (m_trigger.takeCapture(cap)) {
+        const HistorySnapshotPtr snap = m_bufs[m_selectedCh].snapshot();
+        m_capture = SampleView(snap, qMax(cap.first, snap->begin()), cap.last);
+        m_captureMarker = cap.forced ? -1 : qint64(cap.trigger);
+        m_captureNew = true;
+        dirty = true;
+    }
 }
 
-static double computeEnergyMWh(const std::vector<PowerData>& buf, quint64 windowMs) {
-    if (buf.size() < 2) return 0.0;
-
-    quint64 tEnd = buf.back().t_ms;
-    quint64 tStart = (tEnd > windowMs) ? (tEnd - windowMs) : 0;
+void MainWindow::ingestSample(int chIndex, const ParsedSample& s) {
+    const quint64 t_ns = (quint64)qMax<qint64>(0, s.t_ns - m_t0Ns);
+    m_stats[chIndex].append(m_bufs[chIndex], s.v, s.i, s.p, t_ns); // 写入历史并更新窗口统计
+    m_meters[chIndex].add(s.i, s.p, t_ns);
+    if (chIndex == m_selectedCh) m_trigger.feed(m_bufs[chIndex].end() - 1, s.v, s.i, s.p, t_ns);
 
-    // find first index >= tStart
-    int startIdx = (int)buf.size() - 1;
-    while (startIdx > 0 && buf[startIdx-1].t_ms >= tStart) startIdx--;
+    m_chDirty[chIndex] = true;
+}
 
-    double e_mWh = 0.0;
-    for (int i = startIdx + 1; i < (int)buf.size(); ++i) {
-        const auto& a = buf[i-1];
-        const auto& b = buf[i];
-        if (b.t_ms < tStart) continue;
+void MainWindow::updateChannelLabels() {
+    // Update dashboard labels (latest value), 每帧每通道最多一次
+    for (int ch = 0; ch < m_registry.count(); ++ch) {
+        if (!m_chDirty[ch] || m_bufs[ch].empty()) continue;
 
-        double dt_h = (double)(b.t_ms - a.t_ms) / 3600000.0;
-        double p_avg_mW = (a.p + b.p) / 2.0;
-        e_mWh += p_avg_mW * dt_h;
+        const PowerData pt = m_bufs[ch].back();
+        m_chV[ch]->setText(QString::number(pt.v, 'f', 3) + " V");
+        m_chI[ch]->setText(QString::number(pt.i, 'f', 1) + " mA");
+        m_chP[ch]->setText(QString::number(pt.p, 'f', 1) + " mW");
     }
-    return e_mWh;
 }
 
 void MainWindow::updateStatsUI() {
     int chIndex = m_statsChSelector ? m_statsChSelector->currentData().toInt() : 0;
     if (chIndex < 0 || chIndex >= kMaxChannels) chIndex = 0;
 
-    const auto& buf = m_bufs[chIndex];
-    quint64 windowMs = (quint64)(m_statsWindowSec ? m_statsWindowSec->value() : 10) * 1000ULL;
+    // 窗口统计在 ingest 时已经增量算好，这里只是读出来
+    const WindowStats& ws = m_stats[chIndex];
 
-    auto setRow = [&](int r, double PowerData::*member) {
-        double mn, mx, avg, rms;
-        computeStatsWindow(buf, windowMs, member, mn, mx, avg, rms);
-        if (!std::isfinite(mn) || !std::isfinite(mx)) {
+    auto setRow = [&](int r, Series s) {
+        const WindowStats::Result st = ws.stats(s);
+        if (st.n == 0) {
             for (int c=0;c<4;++c) m_statLabel[r][c]->setText("--");
             return;
         }
-        m_statLabel[r][0]->setText(QString::number(mn, 'f', 3));
-        m_statLabel[r][1]->setText(QString::number(mx, 'f', 3));
-        m_statLabel[r][2]->setText(QString::number(avg, 'f', 3));
-        m_statLabel[r][3]->setText(QString::number(rms, 'f', 3));
+        m_statLabel[r][0]->setText(QString::number(st.min, 'f', 3));
+        m_statLabel[r][1]->setText(QString::number(st.max, 'f', 3));
+        m_statLabel[r][2]->setText(QString::number(st.avg, 'f', 3));
+        m_statLabel[r][3]->setText(QString::number(st.rms, 'f', 3));
     };
 
-    setRow(0, &PowerData::v);
-    setRow(1, &PowerData::i);
-    setRow(2, &PowerData::p);
+    setRow(0, Series::V);
+    setRow(1, Series::I);
+    setRow(2, Series::P);
 
-    double e_mWh = computeEnergyMWh(buf, windowMs);
+    double e_mWh = ws.energyMWh();
     m_energyMWh->setText(QString("E: %1 mWh").arg(e_mWh, 0, 'f', 4));
     m_energyWh->setText(QString("E: %1 Wh").arg(e_mWh/1000.0, 0, 'f', 6));
+
+    auto lifeText = [](const EnergyMeter::Total& t) {
+        const quint64 sec = t.ns / 1000000000ULL;
+        return QString("%1 mWh   %2 mAh   (%3:%4:%5)")
+            .arg(t.mWh(), 0, 'f', 3)
+            .arg(t.mAh(), 0, 'f', 3)
+            .arg(sec / 3600)
+            .arg((sec / 60) % 60, 2, 10, QChar('0'))
+            .arg(sec % 60, 2, 10, QChar('0'));
+    };
+    m_lifeConnect->setText(lifeText(m_meters[chIndex].sinceConnect()));
+    m_lifeReset->setText(lifeText(m_meters[chIndex].sinceReset()));
 }
 
 void MainWindow::refreshUI() {
-    if (!dirty) return;
-    dirty = false;
+    drainSamples();
+    if (dirty) {
+        dirty = false;
+        updatePanels();
+    }
+    // 画不画、什么时候画由调度器按可见性和帧预算决定，没有新数据时也要跑：
+    // 之前被限速或看不见的示波器可能这一帧才轮到
+    m_scheduler.run();
+}
+
+void MainWindow::updatePanels() {
+    updateChannelLabels();
 
     // update slider range based on selected channel
     const auto& focusBuf = m_bufs[m_selectedCh];
-    int maxOffset = focusBuf.empty() ? 0 : (int)focusBuf.size() - 1;
-    slider->setRange(0, maxOffset);
+    const qint64 maxOffset = focusBuf.empty() ? 0 : focusBuf.size() - 1;
+    // 回看时按新增样本数推移 offset，画面停在同一段数据上
+    if (offset > 0 && focusBuf.end() > m_focusEnd) offset += qint64(focusBuf.end() - m_focusEnd);
+    m_focusEnd = focusBuf.end();
     if (offset > maxOffset) offset = maxOffset;
+    {
+        // 滑块位置 = offset / m_sliderStep，offset 本身保持整样本精度
+        m_sliderStep = qMax<qint64>(1, (maxOffset + kSliderSteps - 1) / kSliderSteps);
+        QSignalBlocker block(slider);
+        slider->setRange(0, int(maxOffset / m_sliderStep));
+        slider->setValue(int(offset / m_sliderStep));
+    }
 
-    // update plots based on current tab
-    int tabIdx = m_tabs ? m_tabs->currentIndex() : 0;
-    if (tabIdx == 0) {
-        for (int i=0;i<kMaxChannels;++i) {
-            m_overviewScopes[i]->setData(&m_bufs[i], 0, zoom);
-            m_overviewScopes[i]->update();
-        }
-    } else {
-        m_focusScope->setData(&m_bufs[m_selectedCh], offset, zoom);
-        m_focusScope->update();
+    // 只标记收到新数据的通道，空闲通道不产生开销；Focus 还跟着回看 / 选择变化
+    for (int i=0;i<m_registry.count();++i) {
+        if (m_chDirty[i]) m_scheduler.markDirty(m_overviewSlot[i]);
     }
+    m_scheduler.markDirty(m_focusSlot);
+    m_chDirty.fill(false);
 
     updateStatsUI();
+    updateTriggerStatus();
 }
 
-void MainWindow::exportCSV() {
-    QString path = QFileDialog::getSaveFileName(this, "保存 CSV", "", "CSV Files (*.csv)");
-    if (path.isEmpty()) return;
+void MainWindow::applyTrigger() {
+    TriggerConfig c;
+    c.mode = TriggerConfig::Mode(m_trigMode->currentIndex());
+    c.source = Series(m_trigSource->currentIndex());
+    // 类型下拉框：上升沿 / 下降沿 / 高于 / 低于 / 正脉宽 / 负脉宽
+    const int type = m_trigType->currentIndex();
+    c.type = (type < 2) ? TriggerConfig::Type::Edge
+           : (type < 4) ? TriggerConfig::Type::Level : TriggerConfig::Type::PulseWidth;
+    c.polarity = (type % 2 == 0) ? TriggerConfig::Polarity::Rising : TriggerConfig::Polarity::Falling;
+    c.level = float(m_trigLevel->value());
+    c.minWidthNs = quint64(m_trigWidthMin->value() * 1e6);
+    c.maxWidthNs = quint64(m_trigWidthMax->value() * 1e6);
+    c.preSamples = m_trigPre->value();
+    c.postSamples = m_trigPost->value();
+
+    const bool pulse = c.type == TriggerConfig::Type::PulseWidth;
+    m_trigWidthMin->setEnabled(pulse);
+    m_trigWidthMax->setEnabled(pulse);
+
+    m_trigger.setConfig(c);
+    m_capture = SampleView();
+    m_captureMarker = -1;
+    dirty = true;
+}
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) return;
+void MainWindow::updateTriggerStatus() {
+    if (!m_trigger.enabled()) {
+        m_trigStatus->setText("--");
+        return;
+    }
+    QString state;
+    switch (m_trigger.state()) {
+    case TriggerEngine::State::Stopped:    state = "已停止"; break;
+    case TriggerEngine::State::Armed:      state = "等待触发"; break;
+    case TriggerEngine::State::Collecting: state = "采集中"; break;
+    }
+    m_trigStatus->setText(QString("%1 · 已触发 %2 次").arg(state).arg(m_trigger.count()));
+}
 
+// 把各通道视图按行对齐写成 CSV，返回写入的行数，写文件失败返回 -1
+// 每次取 kSegment 行，各通道整块复制出来再按行输出：一个压缩段每通道只解码一次，
+// 不随通道数在每个格子上来回换段。超出某通道长度或读不出来的段写 0
+static qint64 writeCSV(QFile& file, const QStringList& labels, const std::vector<SampleView>& views) {
     QTextStream out(&file);
     out << "Index";
-    for (int ch=0; ch<kMaxChannels; ++ch) {
-        out << QString(",CH%1_V,CH%1_I,CH%1_P").arg(ch+1);
+    for (const QString& label : labels) {
+        out << QString(",%1_V,%1_I,%1_P").arg(label);
     }
     out << "\n";
 
-    // export aligned by index (simple)
-    int len = 0;
-    for (int ch=0; ch<kMaxChannels; ++ch) len = std::max(len, (int)m_bufs[ch].size());
-
-    for (int i=0; i<len; ++i) {
-        out << i;
-        for (int ch=0; ch<kMaxChannels; ++ch) {
-            const auto& b = m_bufs[ch];
-            if (i < (int)b.size()) out << "," << b[i].v << "," << b[i].i << "," << b[i].p;
-            else out << ",0,0,0";
+    qint64 len = 0;
+    for (const SampleView& v : views) len = std::max(len, v.size());
+
+    constexpr int kRows = SampleStore::kSegment;
+    const int nCh = int(views.size());
+    std::vector<float> cols(size_t(nCh) * kSeriesCount * kRows);
+    for (qint64 i0 = 0; i0 < len; i0 += kRows) {
+        const int rows = int(qMin<qint64>(kRows, len - i0));
+        std::fill(cols.begin(), cols.end(), 0.0f);
+        for (int ch=0; ch<nCh; ++ch) {
+            float* dst = cols.data() + size_t(ch) * kSeriesCount * kRows;
+            views[ch].subspan(i0, rows).forEachBlock([&](qint64 i, const float* const c[kSeriesCount], int n) {
+                for (int s = 0; s < kSeriesCount; ++s) std::copy(c[s], c[s] + n, dst + s * kRows + i);
+            });
+        }
+        for (int r=0; r<rows; ++r) {
+            out << i0 + r;
+            for (int ch=0; ch<nCh; ++ch) {
+                const float* src = cols.data() + size_t(ch) * kSeriesCount * kRows + r;
+                out << "," << src[0] << "," << src[kRows] << "," << src[2 * kRows];
+            }
+            out << "\n";
         }
-        out << "\n";
     }
+    out.flush();
+    return (out.status() == QTextStream::Ok && file.error() == QFileDevice::NoError) ? len : -1;
+}
+
+void MainWindow::exportCSV() {
+    QString path = QFileDialog::getSaveFileName(this, "保存 CSV", "", "CSV Files (*.csv)");
+    if (path.isEmpty()) return;
+
+    // export aligned by index (simple)；快照之后继续采集也不影响导出内容
+    // 历史可以有上亿行，格式化和写盘放到线程池里做，界面照常刷新
+    const int nCh = m_registry.count();
+    QStringList labels;
+    std::vector<SampleView> views;
+    for (int ch=0; ch<nCh; ++ch) {
+        labels << m_registry.label(ch).replace(' ', '_');
+        views.push_back(m_bufs[ch].view());
+    }
+
+    QPointer<MainWindow> self(this);
+    QThreadPool::globalInstance()->start([self, labels, views, path] {
+        QFile file(path);
+        const qint64 rows = file.open(QIODevice::WriteOnly) ? writeCSV(file, labels, views) : -1;
+        const QString error = file.errorString();
+        file.close();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, rows, path, error] {
+            if (!self) return;
+            if (rows < 0) {
+                self->logWindow->append(QString("<font color='#ffa726'>[系统] 导出 %1 失败：%2</font>")
+                                            .arg(path.toHtmlEscaped(), error.toHtmlEscaped()));
+            } else {
+                self->logWindow->append(QString("<font color='gray'>[系统] 已导出 %1 行到 %2</font>")
+                                            .arg(rows).arg(path.toHtmlEscaped()));
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::clearAll() {
-    for (auto& b : m_bufs) b.clear();
+    for (int ch = 0; ch < kMaxChannels; ++ch) {
+        m_bufs[ch].clear();
+        m_stats[ch].reset(m_bufs[ch]);
+    }
     logWindow->clear();
-    dirty = true;
+    applyTrigger(); // 采集窗口指向清空前的数据，丢掉重新布防
+    markAllChannelsDirty();
 }
@@ -2,10 +2,16 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTemporaryDir>
 #include <array>
 #include <vector>
 #include <QtGlobal>
 #include "oscilloscope.h"
+#include "channelregistry.h"
+#include "windowstats.h"
+#include "energymeter.h"
+#include "renderscheduler.h"
+#include "triggerengine.h"
 
 class QLabel;
 class QTextEdit;
@@ -13,7 +19,9 @@ class QPushButton;
 class QSlider;
 class QComboBox;
 class QSpinBox;
+class QDoubleSpinBox;
 class QTabWidget;
+class QGridLayout;
 class QThread;
 class SerialWorker;
 struct ParsedSample;
@@ -23,6 +31,7 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
 
 protected:
     bool eventFilter(QObject* watched, QEvent* event) override;
@@ -33,38 +42,80 @@ private slots:
     void refreshUI();
     void exportCSV();
     void clearAll();
-    void onSampleReady(const ParsedSample& s);
 
 private:
     void setupUI();
     void setSelectedChannel(int chIndex);
     void updateStatsUI();
-
-    static constexpr int kMaxChannels = 6;
+    void updatePanels();
+    void applyTrigger();
+    void updateTriggerStatus();
+    void drainSamples();
+    void ingestSample(int chIndex, const ParsedSample& s);
+    void updateChannelLabels();
+    void ensureChannelUI(int chIndex);
+    void markAllChannelsDirty();
+
+    // ---- Devices
+    int findDevice(const QString& spec) const;
+    void connectDevice(const QString& spec);
+    void disconnectDevice(int devIndex);
+    QString selectedSpec() const;
+    void updateConnectButton();
+
+    static constexpr int kMaxChannels = 64;
 
     // ---- Top / Connection
     QComboBox *portSelector = nullptr;
     QPushButton *btnConnect = nullptr;
 
-    // ---- Buffers (per-channel)
-    std::array<std::vector<PowerData>, kMaxChannels> m_bufs{};
+    // ---- Buffers (per-channel, 按全局通道索引，未登记的通道为空)
+    ChannelRegistry m_registry{kMaxChannels};
+    std::array<SampleStore, kMaxChannels> m_bufs{};
+    std::array<WindowStats, kMaxChannels> m_stats{}; // 统计面板的滑动窗口，所有通道都在算
+    std::array<EnergyMeter, kMaxChannels> m_meters{}; // 累计能量/电荷，清空波形不影响
+    QTemporaryDir m_spillDir; // 各通道的落盘历史，退出时删除
 
     // ---- Plotting
     QTabWidget* m_tabs = nullptr;
-    std::array<Oscilloscope*, kMaxChannels> m_overviewScopes{};
+    QGridLayout* m_overviewGrid = nullptr;
+    std::array<Oscilloscope*, kMaxChannels> m_overviewScopes{}; // 通道登记时才创建
     Oscilloscope* m_focusScope = nullptr;
-    int m_selectedCh = 0; // 0..5
+    RenderScheduler m_scheduler; // 什么时候给哪个示波器喂数据、重画
+    std::array<int, kMaxChannels> m_overviewSlot{};
+    int m_focusSlot = -1;
+    int m_selectedCh = 0; // 全局通道索引
 
     // ---- Channel cards (right panel)
     std::array<QLabel*, kMaxChannels> m_chV{};
     std::array<QLabel*, kMaxChannels> m_chI{};
     std::array<QLabel*, kMaxChannels> m_chP{};
+    std::array<bool, kMaxChannels> m_chDirty{}; // 有新样本，下一帧刷新数值和概览曲线
+    QGridLayout* m_cardsLayout = nullptr;
     QTextEdit *logWindow = nullptr;
 
     // ---- History / zoom
     QSlider *slider = nullptr;
     double zoom = 1.0;
-    int offset = 0;
+    qint64 offset = 0;       // 从最新样本往回的样本数
+    qint64 m_sliderStep = 1; // QSlider 只有 int：历史超过 kSliderSteps 时一格对应多个样本
+    static constexpr qint64 kSliderSteps = qint64(1) << 30;
+    quint64 m_focusEnd = 0; // 上次刷新时 Focus 通道的 end()，回看时据此保持画面不动
+
+    // ---- Trigger (Focus 通道)
+    TriggerEngine m_trigger;
+    SampleView m_capture;          // 最近一次采集，冻结在快照上；为空时 Focus 显示实时波形
+    qint64 m_captureMarker = -1;   // 触发点，强制采集时为 -1
+    bool m_captureNew = false;     // 新采集第一次显示时缩放到整个窗口
+    QComboBox* m_trigMode = nullptr;
+    QComboBox* m_trigSource = nullptr;
+    QComboBox* m_trigType = nullptr;
+    QDoubleSpinBox* m_trigLevel = nullptr;
+    QDoubleSpinBox* m_trigWidthMin = nullptr;
+    QDoubleSpinBox* m_trigWidthMax = nullptr;
+    QSpinBox* m_trigPre = nullptr;
+    QSpinBox* m_trigPost = nullptr;
+    QLabel* m_trigStatus = nullptr;
 
     // ---- Stats panel
     QComboBox* m_statsChSelector = nullptr;
@@ -72,15 +123,24 @@ private:
     QLabel* m_statLabel[3][4]{}; // 0=V,1=I,2=P x (min,max,avg,rms)
     QLabel* m_energyMWh = nullptr;
     QLabel* m_energyWh  = nullptr;
-
-    // ---- IO thread
-    QThread* ioThread = nullptr;
-    SerialWorker* worker = nullptr;
-    bool connected = false;
+    QLabel* m_lifeConnect = nullptr; // 连接以来累计
+    QLabel* m_lifeReset = nullptr;   // 复位以来累计
+
+    // ---- IO threads: 每个设备一个线程 + SerialWorker
+    struct Device {
+        int id = -1;          // ChannelRegistry 设备号
+        QString spec;
+        QThread* thread = nullptr;
+        SerialWorker* worker = nullptr;
+        quint64 reportedDrops = 0;
+        qint64 lastDropReportMs = -1000;
+    };
+    std::vector<Device> m_devices;
 
     // ---- Timing & repaint
     bool dirty = false;
     QElapsedTimer* m_clock = nullptr;
+    qint64 m_t0Ns = 0; // 历史时间戳的零点 (monotonicNs)
 };
 
 #endif
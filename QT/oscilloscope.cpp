@@ -1,22 +1,29 @@
 #include "oscilloscope.h"
+#include <QElapsedTimer>
 #include <QPainter>
-#include <QPainterPath>
+#include <QPointer>
 #include <QtMath>
 #include <cmath>
 #include <algorithm> // for std::max
 Oscilloscope::Oscilloscope(QColor vCol, QColor iCol, QColor pCol, QWidget *parent)
-    : QWidget(parent), colorV(vCol), colorI(iCol), colorP(pCol)
+    : QWidget(parent), colorV(vCol), colorI(iCol), colorP(pCol),
+      m_renderer(std::make_shared<ScopeRenderer>())
 {
     setBackgroundRole(QPalette::Base);
     setAutoFillBackground(true);
     showV = true; showI = true; showP = true;
     m_zoom = 5.0;
 }
-void Oscilloscope::setData(const std::vector<PowerData> *data, int offset, double zoom) {
-    m_data = data;
+void Oscilloscope::setData(const SampleView &view, qint64 offset, double zoom) {
+    m_view = view;
     m_offset = offset;
     //m_zoom = zoom;acul
 }
+void Oscilloscope::fitToView() {
+    const qint64 total = m_view.size();
+    if (total < 2 || width() <= 0) return;
+    setZoom((double)width() / total);
+}
 // 【新增】处理鼠标滚轮事件
 void Oscilloscope::wheelEvent(QWheelEvent *event) {
     // 获取滚轮滚动的角度 delta
@@ -32,108 +39,74 @@ void Oscilloscope::wheelEvent(QWheelEvent *event) {
     // 滚轮向上滚（正数）：放大（Zoom In），间距变大
     // 滚轮向下滚（负数）：缩小（Zoom Out），间距变小
     if (step > 0) {
-        m_zoom *= 1.2; // 每次放大 20%
+        setZoom(m_zoom * 1.2); // 每次放大 20%
     } else {
-        m_zoom /= 1.2; // 每次缩小 20%
+        setZoom(m_zoom / 1.2); // 每次缩小 20%
     }
-    // 限制缩放范围，防止无限放大或缩小
-    // 0.1 表示 10个点挤在1像素里（看宏观趋势）
-    // 50.0 表示 1个点占50像素（看极细微变化）
-    if (m_zoom < 0.1) m_zoom = 0.1;
-    if (m_zoom > 50.0) m_zoom = 50.0;
+}
+
+void Oscilloscope::setZoom(double zoom) {
+    // 缩小到整段历史正好铺满屏幕为止（走金字塔，点数再多也按像素计算）
+    // 200.0 表示 1个点占200像素（看极细微变化）
+    const qint64 total = m_view.size();
+    const double minZoom = (total > 1) ? qMin(1.0, (double)width() / total) : 1.0;
+    m_zoom = qBound(minZoom, zoom, 200.0);
     // 触发重绘
     update();
 }
 
-// 【新增函数】计算当前视图内数据的最大值
-double Oscilloscope::calculateVisibleMax(double PowerData::*member) {
-    if (!m_data || m_data->empty()) return 10.0;
-    double maxVal = 0.0;
-    int rightIdx = m_data->size() - 1 - m_offset;
-    // 使用当前的 m_zoom 计算屏幕内能容纳多少个点
-    // 如果 m_zoom 很大，i * m_zoom 增长很快，循环次数其实变少了（因为很快超出 width）
-    // 为了准确遍历屏幕上的像素，我们还是按像素循环
-    for (int i = 0; i < width(); ++i) {
-        double dataIndexStep = i / m_zoom; // 计算当前像素对应第几个数据点
-        int idx = rightIdx - (int)dataIndexStep;
-        if(idx<0) break;
-        double val = std::abs((*m_data)[idx].*member);
-        if(val>maxVal) maxVal = val;
-    }
-    if(maxVal<0.1) maxVal = 1.0;
-    return maxVal * 1.2;
+ScopeFrame Oscilloscope::currentFrame() const {
+    ScopeFrame f;
+    f.view = m_view;
+    f.offset = m_offset;
+    f.zoom = m_zoom;
+    f.size = size();
+    f.dpr = devicePixelRatioF();
+    f.showV = showV; f.showI = showI; f.showP = showP;
+    f.colorV = colorV; f.colorI = colorI; f.colorP = colorP;
+    f.marker = m_marker;
+    return f;
 }
-double Oscilloscope::calculateVisibleRms(double PowerData::*member) const {
-    if (!m_data || m_data->empty()) return 0.0;
 
-    double sumSq = 0.0;
-    int n = 0;
-    int rightIdx = (int)m_data->size() - 1 - m_offset;
+void Oscilloscope::scheduleRender() {
+    if (m_rendering) {
+        m_renderPending = true;
+        return;
+    }
+    const ScopeFrame frame = currentFrame();
+    if (!m_image.isNull() && frame.sameAs(m_submitted)) return;
+    if (frame.size.isEmpty()) return;
 
-    for (int px = 0; px < width(); ++px) {
-        int dataDist = (int)(px / m_zoom);
-        int idx = rightIdx - dataDist;
-        if (idx < 0) break;
+    m_submitted = frame;
+    m_rendering = true;
+    QPointer<Oscilloscope> self(this);
+    std::shared_ptr<ScopeRenderer> renderer = m_renderer;
+    ScopeRenderer::pool()->start([self, renderer, frame] {
+        QElapsedTimer t;
+        t.start();
+        QImage image = renderer->render(frame);
+        const double costMs = t.nsecsElapsed() / 1e6;
+        QMetaObject::invokeMethod(ScopeRenderer::pool(), [self, image, costMs] {
+            if (self) self->onFrameRendered(image, costMs);
+        }, Qt::QueuedConnection);
+    });
+}
 
-        double v = (*m_data)[idx].*member;
-        sumSq += v * v;
-        n++;
+void Oscilloscope::onFrameRendered(QImage image, double costMs) {
+    m_image = std::move(image);
+    // 整幅重画和增量滚动耗时差得多，平滑一下，偶尔一次整幅重画不至于让帧率大起大落
+    m_costMs = (m_costMs == 0.0) ? costMs : 0.8 * m_costMs + 0.2 * costMs;
+    m_rendering = false;
+    if (m_renderPending) {
+        m_renderPending = false;
+        scheduleRender();
     }
-
-    return (n > 0) ? std::sqrt(sumSq / n) : 0.0;
+    QWidget::update();
 }
 
 void Oscilloscope::paintEvent(QPaintEvent *) {
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.fillRect(rect(), Qt::black);
-    // 网格绘制
-    painter.setPen(QPen(QColor(60, 60, 60), 1, Qt::DotLine));
-    for (int x = width(); x > 0; x -= 50) painter.drawLine(x, 0, x, height());
-    for (int y = 0; y < height(); y += height() / 4) painter.drawLine(0, y, width(), y);
-    if (!m_data || m_data->size() < 2) return;
-    double rangeV = calculateVisibleMax(&PowerData::v);
-    double rangeI = calculateVisibleMax(&PowerData::i);
-    double rangeP = calculateVisibleMax(&PowerData::p);
-    drawTrace(&painter, &PowerData::p, rangeP, colorP, showP);
-    drawTrace(&painter, &PowerData::i, rangeI, colorI, showI);
-    drawTrace(&painter, &PowerData::v, rangeV, colorV, showV);
-    // 显示当前量程和缩放倍率
-    double rmsV = calculateVisibleRms(&PowerData::v);
-    double rmsI = calculateVisibleRms(&PowerData::i);
-    double rmsP = calculateVisibleRms(&PowerData::p);
-
-    painter.setPen(Qt::white);
-    painter.drawText(10, 20,
-                     QString("RMS: V=%1 V  I=%2 mA  P=%3 mW")
-                         .arg(rmsV, 0, 'f', 3)
-                         .arg(rmsI, 0, 'f', 1)
-                         .arg(rmsP, 0, 'f', 1)
-                     );
-
-    // 显示横轴缩放信息
-    painter.drawText(width() - 100, 20, QString("Zoom: x%1").arg(m_zoom, 0, 'f', 1));
-}
-void Oscilloscope::drawTrace(QPainter *p, double PowerData::*member, double range, QColor color, bool visible) {
-    if (!visible) return;
-    p->setPen(QPen(color, 2));
-    QPainterPath path;
-    int rightIdx = m_data->size() - 1 - m_offset;
-    bool first = true;
-    // 这里的绘图逻辑也需要稍微适配 zoom
-    // 我们按照屏幕像素 x 从右向左遍历
-    for (int i = 0; i < width(); ++i) {
-        // 计算当前像素对应的数据索引
-        // i 是距离右边的像素数，除以 zoom 得到距离最新的数据点个数
-        int dataDist = (int)(i / m_zoom);
-        int idx = rightIdx - dataDist;
-        if (idx < 0) break;
-        double val = std::abs((*m_data)[idx].*member);
-        double x = width() - i; // x 坐标就是当前像素位置
-        double y = height() - ((val / range) * height());
-        y = qBound(0.0, y, (double)height());
-        if (first) { path.moveTo(x, y); first = false; }
-        else { path.lineTo(x, y); }
-    }
-    p->drawPath(path);
+    if (m_image.isNull()) painter.fillRect(rect(), Qt::black);
+    else painter.drawImage(0, 0, m_image); // 尺寸刚变时先贴旧的，新的一帧很快就到
+    scheduleRender();
 }
@@ -3,21 +3,30 @@
 
 #include <QWidget>
 #include <QtGlobal>
-#include <vector>
+#include <QImage>
 #include <QWheelEvent>
+#include <memory>
+#include "scoperenderer.h"
 
-struct PowerData {
-    double v; // 电压 (V)
-    double i; // 电流 (mA)
-    double p; // 功率 (mW)
-    quint64 t_ms = 0; // 时间戳 (ms, 上位机)
-};
-
+// 示波器控件：画面由渲染线程池画到 QImage，paintEvent 只贴最近画好的一张
 class Oscilloscope : public QWidget {
     Q_OBJECT
 public:
     explicit Oscilloscope(QColor vCol, QColor iCol, QColor pCol, QWidget *parent = nullptr);
-    void setData(const std::vector<PowerData> *data, int offset, double zoom);
+    // view 是某一时刻的快照，绘制期间写入方继续写也不受影响
+    void setData(const SampleView &view, qint64 offset, double zoom);
+    // 触发点的逻辑下标，-1 不画
+    void setMarker(qint64 index) { m_marker = index; }
+    // 横轴缩放（像素 / 样本），限制在“整段历史铺满宽度”到 200 之间
+    void setZoom(double zoom);
+    double zoom() const { return m_zoom; }
+    // 缩放到整段 view 正好铺满宽度（看触发采集的窗口用）
+    void fitToView();
+
+    // 渲染任务还没回来
+    bool rendering() const { return m_rendering; }
+    // 最近几帧的渲染耗时（毫秒，滑动平均），供 RenderScheduler 控制帧率
+    double renderCostMs() const { return m_costMs; }
 
     bool showV = true;
     bool showI = true;
@@ -27,17 +36,23 @@ protected:
     void paintEvent(QPaintEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
 private:
-private:
-    double calculateVisibleRms(double PowerData::*member) const;
+    ScopeFrame currentFrame() const;
+    // 输入变了就提交一次渲染；同一时刻每个示波器最多一个任务在跑，期间的变化合并成下一次
+    void scheduleRender();
+    void onFrameRendered(QImage image, double costMs);
 
-    void drawTrace(class QPainter *p, double PowerData::*member, double range, QColor color, bool visible);
-    // 辅助函数：自适应量程
-    double calculateVisibleMax(double PowerData::*member) ;
-
-    const std::vector<PowerData> *m_data = nullptr;
-    int m_offset = 0;
+    SampleView m_view;
+    qint64 m_offset = 0;
     double m_zoom = 1.0;
+    qint64 m_marker = -1;
     QColor colorV, colorI, colorP;
+
+    std::shared_ptr<ScopeRenderer> m_renderer; // 任务里也持有一份，控件先析构也不要紧
+    ScopeFrame m_submitted;   // 最近一次提交渲染的输入
+    QImage m_image;           // 最近画好的一帧
+    bool m_rendering = false;
+    bool m_renderPending = false;
+    double m_costMs = 0.0;
 };
 
 #endif
@@ -0,0 +1,72 @@
+#pragma once
+#include <QtGlobal>
+#include <QtEndian>
+#include <array>
+#include <cstring>
+
+// 二进制采样帧，与 MCU/powerframe.h 保持一致
+// 线上格式 (小端序, 21 字节):
+//   u16 header=0xAA55 | u8 channel | u32 timestamp(ms) | f32 V | f32 mA | f32 mW | u16 crc16
+// crc16 = CRC-16/CCITT-FALSE，覆盖 crc16 之前的全部字节
+namespace PowerFrame {
+
+constexpr int kSize = 21;
+constexpr int kCrcOffset = kSize - 2;
+constexpr quint16 kHeader = 0xAA55;
+// header 按小端发送：先 0x55 再 0xAA。0xAA 不是 ASCII，所以不会出现在文本行里
+constexpr char kHeaderBytes[2] = { char(0x55), char(0xAA) };
+
+struct Frame {
+    quint8  channel;
+    quint32 timestamp; // ms (设备时钟)
+    float   v;         // V
+    float   i;         // mA
+    float   p;         // mW
+};
+
+namespace detail {
+constexpr std::array<quint16, 256> makeCrcTable() {
+    std::array<quint16, 256> t{};
+    for (int n = 0; n < 256; ++n) {
+        quint16 crc = quint16(n << 8);
+        for (int b = 0; b < 8; ++b)
+            crc = (crc & 0x8000) ? quint16((crc << 1) ^ 0x1021) : quint16(crc << 1);
+        t[n] = crc;
+    }
+    return t;
+}
+constexpr std::array<quint16, 256> kCrcTable = makeCrcTable();
+} // namespace detail
+
+inline quint16 crc16(const char* data, int len) {
+    quint16 crc = 0xFFFF;
+    for (int k = 0; k < len; ++k)
+        crc = quint16((crc << 8) ^ detail::kCrcTable[((crc >> 8) ^ quint8(data[k])) & 0xFF]);
+    return crc;
+}
+
+// p 至少有 kSize 字节；帧头或 CRC 不对时返回 false
+inline bool decode(const char* p, Frame& out) {
+    if (qFromLittleEndian<quint16>(p) != kHeader) return false;
+    if (qFromLittleEndian<quint16>(p + kCrcOffset) != crc16(p, kCrcOffset)) return false;
+
+    out.channel   = quint8(p[2]);
+    out.timestamp = qFromLittleEndian<quint32>(p + 3);
+    out.v = qFromLittleEndian<float>(p + 7);
+    out.i = qFromLittleEndian<float>(p + 11);
+    out.p = qFromLittleEndian<float>(p + 15);
+    return true;
+}
+
+// 写出 kSize 字节（模拟器 / 基准测试用）
+inline void encode(const Frame& f, char* out) {
+    qToLittleEndian<quint16>(kHeader, out);
+    out[2] = char(f.channel);
+    qToLittleEndian<quint32>(f.timestamp, out + 3);
+    qToLittleEndian<float>(f.v, out + 7);
+    qToLittleEndian<float>(f.i, out + 11);
+    qToLittleEndian<float>(f.p, out + 15);
+    qToLittleEndian<quint16>(crc16(out, kCrcOffset), out + kCrcOffset);
+}
+
+} // namespace PowerFrame
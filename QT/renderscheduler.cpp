@@ -0,0 +1,52 @@
+#include "renderscheduler.h"
+#include "oscilloscope.h"
+
+RenderScheduler::Budget RenderScheduler::budget(Tier tier) {
+    switch (tier) {
+    case Tier::Focus:    return { 33, 0.5 };  // 30 fps，最多占半个渲染线程
+    case Tier::Overview: break;
+    }
+    return { 100, 0.25 };                     // 缩略图 10 fps，全部缩略图合计最多占 1/4
+}
+
+bool RenderScheduler::visible(const Oscilloscope* scope) {
+    // 所在标签页没显示时 isVisible() 为 false；滚出滚动区域时可见区域为空
+    return scope->isVisible() && !scope->window()->isMinimized() && !scope->visibleRegion().isEmpty();
+}
+
+int RenderScheduler::add(Oscilloscope* scope, Tier tier, std::function<void()> refresh) {
+    Slot s;
+    s.scope = scope;
+    s.tier = tier;
+    s.refresh = std::move(refresh);
+    m_slots.push_back(std::move(s));
+    return int(m_slots.size()) - 1;
+}
+
+void RenderScheduler::run() {
+    if (!m_clock.isValid()) m_clock.start();
+    const qint64 now = m_clock.elapsed();
+
+    // 每档的负载：看得见、有新数据的示波器最近的单帧渲染耗时之和
+    constexpr int kTiers = 2;
+    double load[kTiers] = {};
+    for (Slot& s : m_slots) {
+        s.active = s.dirty && visible(s.scope);
+        if (s.active) load[int(s.tier)] += s.scope->renderCostMs();
+    }
+
+    for (Slot& s : m_slots) {
+        if (!s.active || s.scope->rendering()) continue; // 上一帧还没画完，数据留到下次一起给
+
+        // 耗时超出预算时按 负载 / 占比 拉长间隔
+        const Budget b = budget(s.tier);
+        const qint64 interval = qMax(b.intervalMs, qint64(load[int(s.tier)] / b.share));
+        if (s.fed && now - s.lastMs < interval) continue;
+
+        s.refresh();
+        s.scope->update();
+        s.dirty = false;
+        s.fed = true;
+        s.lastMs = now;
+    }
+}
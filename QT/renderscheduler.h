@@ -0,0 +1,47 @@
+#pragma once
+#include <QElapsedTimer>
+#include <functional>
+#include <vector>
+
+class Oscilloscope;
+
+// 示波器重绘调度
+//
+// 每个示波器登记一个槽位，有新数据时 markDirty。run() 每个 UI 帧调用一次，
+// 只给“脏、看得见、到点了、上一帧已经画完”的示波器喂数据并请求重绘。
+// 看不见的（标签页没显示、滚出概览区域、窗口最小化）保持脏状态，重新露出来时再画。
+//
+// 概览缩略图和 Focus 各有一档预算：最短刷新间隔，以及这一档渲染最多占用的时间比例。
+// 渲染耗时超出预算时按耗时拉长间隔（降帧率），不会排队积压；概览档的耗时按档内
+// 看得见且有新数据的示波器合计，开销随活跃通道数增长，但总量封顶。
+class RenderScheduler {
+public:
+    enum class Tier { Overview, Focus };
+
+    // refresh 把最新数据交给示波器 (setData)，调度器随后 update()；返回槽位号
+    int add(Oscilloscope* scope, Tier tier, std::function<void()> refresh);
+    void markDirty(int slot) { if (slot >= 0) m_slots[size_t(slot)].dirty = true; }
+
+    void run();
+
+private:
+    struct Budget {
+        qint64 intervalMs; // 最短刷新间隔
+        double share;      // 这一档渲染耗时占墙钟时间的上限
+    };
+    static Budget budget(Tier tier);
+    static bool visible(const Oscilloscope* scope);
+
+    struct Slot {
+        Oscilloscope* scope = nullptr;
+        Tier tier = Tier::Overview;
+        std::function<void()> refresh;
+        bool dirty = true;
+        qint64 lastMs = 0;
+        bool fed = false;     // 还没喂过数据，不受间隔限制
+        bool active = false;  // 本轮脏且看得见
+    };
+
+    QElapsedTimer m_clock;
+    std::vector<Slot> m_slots;
+};
@@ -0,0 +1,274 @@
+#include "samplestore.h"
+#include "coldstore.h"
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POWERCORE_SSE2 1
+#endif
+
+void SeriesAgg::add(const float* p, int count) {
+    if (count <= 0) return;
+    constexpr int kLanes = 4;
+    float lo[kLanes], hi[kLanes];
+    double s[kLanes], sq[kLanes];
+    int j = 0;
+
+#ifdef POWERCORE_SSE2
+    // minps(lo, x) = lo < x ? lo : x，与 qMin(lo, x) 相同；maxps(x, hi) = x > hi ? x : hi，与 qMax(hi, x) 相同。
+    // 遇到 NaN、±0 时 min / max 也与下面的逐个计算一致
+    __m128 vlo = _mm_set1_ps(p[0]), vhi = vlo;
+    __m128d s01 = _mm_setzero_pd(), s23 = s01, sq01 = s01, sq23 = s01;
+    for (; j + kLanes <= count; j += kLanes) {
+        const __m128 x = _mm_loadu_ps(p + j);
+        vlo = _mm_min_ps(vlo, x);
+        vhi = _mm_max_ps(x, vhi);
+        const __m128d x01 = _mm_cvtps_pd(x);
+        const __m128d x23 = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+        s01 = _mm_add_pd(s01, x01);
+        s23 = _mm_add_pd(s23, x23);
+        sq01 = _mm_add_pd(sq01, _mm_mul_pd(x01, x01));
+        sq23 = _mm_add_pd(sq23, _mm_mul_pd(x23, x23));
+    }
+    _mm_storeu_ps(lo, vlo);
+    _mm_storeu_ps(hi, vhi);
+    _mm_storeu_pd(s, s01);
+    _mm_storeu_pd(s + 2, s23);
+    _mm_storeu_pd(sq, sq01);
+    _mm_storeu_pd(sq + 2, sq23);
+#else
+    for (int l = 0; l < kLanes; ++l) {
+        lo[l] = hi[l] = p[0];
+        s[l] = sq[l] = 0.0;
+    }
+    for (; j + kLanes <= count; j += kLanes) {
+        for (int l = 0; l < kLanes; ++l) {
+            const float x = p[j + l];
+            lo[l] = qMin(lo[l], x);
+            hi[l] = qMax(hi[l], x);
+            s[l] += x;
+            sq[l] += double(x) * x;
+        }
+    }
+#endif
+
+    for (; j < count; ++j) {
+        lo[0] = qMin(lo[0], p[j]);
+        hi[0] = qMax(hi[0], p[j]);
+        s[0] += p[j];
+        sq[0] += double(p[j]) * p[j];
+    }
+
+    SeriesAgg r;
+    r.min = qMin(qMin(lo[0], lo[1]), qMin(lo[2], lo[3]));
+    r.max = qMax(qMax(hi[0], hi[1]), qMax(hi[2], hi[3]));
+    r.sum = (s[0] + s[1]) + (s[2] + s[3]);
+    r.sumSq = (sq[0] + sq[1]) + (sq[2] + sq[3]);
+    r.n = count;
+    merge(r);
+}
+
+void HotChunk::fillBuckets(int k) {
+    int size = bucketSize(0);
+    int start = k + 1 - size;
+    for (int s = 0; s < kSeriesCount; ++s) {
+        SeriesAgg a;
+        a.add(col[s] + start, size);
+        aggs[s][start / size] = { a.min, a.max, a.sum, a.sumSq };
+    }
+
+    for (int level = 1; level < kLevels && (k + 1) % bucketSize(level) == 0; ++level) {
+        size = bucketSize(level);
+        start = k + 1 - size;
+        const int first = levelBase(level - 1) + start / bucketSize(level - 1);
+        for (int s = 0; s < kSeriesCount; ++s) {
+            const BucketAgg* child = aggs[s] + first;
+            BucketAgg b = child[0];
+            for (int j = 1; j < kFanout; ++j) {
+                b.min = qMin(b.min, child[j].min);
+                b.max = qMax(b.max, child[j].max);
+                b.sum += child[j].sum;
+                b.sumSq += child[j].sumSq;
+            }
+            aggs[s][levelBase(level) + start / size] = b;
+        }
+    }
+}
+
+void HotChunk::aggregate(quint64 from, quint64 to, int s0, int s1, SeriesAgg* out) const {
+    int k = int(from - first);
+    const int end = int(to - first);
+
+    // level -1 表示单个样本；能往上走就往上走，桶超出区间再往下退。
+    // 每一步对 [s0, s1) 各列做同样的事，桶的选择只算一次
+    int level = -1;
+    int size = 1;
+    while (k < end) {
+        while (level + 1 < kLevels) {
+            const int next = bucketSize(level + 1);
+            if (k % next != 0 || k + next > end) break;
+            ++level;
+            size = next;
+        }
+        while (level >= 0 && k + size > end) {
+            --level;
+            size = (level >= 0) ? bucketSize(level) : 1;
+        }
+
+        if (level < 0) {
+            // 到下一个第 0 层桶边界（或区间末尾）之前都是单个样本，成段处理
+            const int run = qMin(end, (k / bucketSize(0) + 1) * bucketSize(0)) - k;
+            for (int s = s0; s < s1; ++s) out[s - s0].add(col[s] + k, run);
+            k += run;
+        } else {
+            const int b = levelBase(level) + k / size;
+            for (int s = s0; s < s1; ++s) out[s - s0].merge(aggs[s][b], size);
+            k += size;
+        }
+    }
+}
+
+float HistorySnapshot::coldValue(Series s, quint64 idx) const {
+    return m_cold ? m_cold->value(s, idx) : 0.0f;
+}
+
+quint64 HistorySnapshot::coldTime(quint64 idx) const {
+    return m_cold ? m_cold->time(idx) : 0;
+}
+
+void HistorySnapshot::aggregate(quint64 from, quint64 to, int s0, int s1, SeriesAgg* out) const {
+    if (from < m_hotBegin) {
+        const quint64 coldTo = qMin(to, m_hotBegin);
+        if (m_cold) m_cold->aggregate(from, coldTo, s0, s1, out);
+        from = coldTo;
+    }
+    while (from < to) {
+        const HotChunk* c = hot(from);
+        const quint64 stop = qMin(to, c->first + HotChunk::kSize);
+        c->aggregate(from, stop, s0, s1, out);
+        from = stop;
+    }
+}
+
+const float* HistorySnapshot::chunk(Series s, quint64 idx, int& n) const {
+    if (idx >= m_end) return nullptr;
+    const float* p = nullptr;
+    if (idx < m_hotBegin) {
+        if (!m_cold) return nullptr;
+        p = m_cold->chunk(s, idx, n);
+    } else {
+        const HotChunk* c = hot(idx);
+        const int k = int(idx - c->first);
+        p = c->col[int(s)] + k;
+        n = HotChunk::kSize - k;
+    }
+    if (p) n = int(qMin<quint64>(quint64(n), m_end - idx));
+    return p;
+}
+
+SampleStore::SampleStore() : SampleStore(kDefaultCapacity) {}
+
+SampleStore::SampleStore(int capacity, qint64 compressedBytes)
+    : m_cold(std::make_unique<ColdStore>(compressedBytes)) {
+    static std::atomic<quint64> nextId{ 1 };
+    m_live.m_storeId = nextId.fetch_add(1);
+    m_maxChunks = qMax(2, (capacity + kSegment - 1) / kSegment);
+    publish(); // snapshot() 从一开始就不为空
+}
+
+SampleStore::~SampleStore() = default;
+
+bool SampleStore::enableSpill(const QString& path, QString* error) {
+    Q_ASSERT(m_live.m_end == 0);
+
+    auto cold = std::make_unique<ColdStore>(path);
+    if (!cold->open()) {
+        if (error) *error = cold->errorString();
+        return false;
+    }
+    m_cold = std::move(cold);
+    return true;
+}
+
+bool SampleStore::spilling() const {
+    return m_cold->onDisk();
+}
+
+quint64 SampleStore::compressedBytes() const {
+    return m_cold->storedBytes();
+}
+
+void SampleStore::clear() {
+    const quint64 next = (m_live.m_end + kSegment - 1) / kSegment * kSegment;
+    m_tail.reset();
+    m_live.m_chunks.clear();
+    m_live.m_cold.reset();
+    m_live.m_begin = m_live.m_hotBegin = m_live.m_end = next;
+    publish(); // 先放掉旧快照对磁盘映射的引用，ColdStore 才有机会截断文件
+    m_cold->reset(next);
+}
+
+void SampleStore::publish() {
+    ++m_live.m_version;
+    std::atomic_store(&m_published, HistorySnapshotPtr(std::make_shared<HistorySnapshot>(m_live)));
+}
+
+HistorySnapshotPtr SampleStore::snapshot() const {
+    return std::atomic_load(&m_published);
+}
+
+// 热数据从 hotBegin 开始时 begin() 的值：压缩段与热数据接得上才从压缩段算起，
+// 落盘失败后中间有缺口，这时只用热数据
+static quint64 beginWith(const ColdMapping* cold, quint64 coldBegin, quint64 hotBegin) {
+    if (cold && cold->end() >= hotBegin) return qMin(coldBegin, hotBegin);
+    return hotBegin;
+}
+
+quint64 SampleStore::nextBegin() const {
+    quint64 hot = m_live.m_hotBegin;
+    if (m_live.m_end % kSegment == 0 && int(m_live.m_chunks.size()) >= m_maxChunks) hot = m_live.m_chunks[1]->first;
+    const ColdMapping* cold = m_live.m_cold.get();
+    quint64 coldBegin = cold ? cold->begin() : 0;
+    // 这次 push 写满一块就会封段，内存里的压缩段先按预算淘汰
+    if ((m_live.m_end + 1) % kSegment == 0) coldBegin = qMax(coldBegin, m_cold->beginAfterAppend());
+    return beginWith(cold, coldBegin, hot);
+}
+
+void SampleStore::updateBegin() {
+    if (!m_live.m_chunks.empty()) m_live.m_hotBegin = m_live.m_chunks.front()->first;
+    const ColdMapping* cold = m_live.m_cold.get();
+    m_live.m_begin = beginWith(cold, cold ? cold->begin() : 0, m_live.m_hotBegin);
+}
+
+void SampleStore::startChunk(quint64 first) {
+    // 最旧的块退役；还被快照引用的话，内存等最后一个快照释放时才回收
+    if (int(m_live.m_chunks.size()) >= m_maxChunks) m_live.m_chunks.erase(m_live.m_chunks.begin());
+
+    m_tail = std::make_shared<HotChunk>();
+    m_tail->first = first;
+    m_live.m_chunks.push_back(m_tail);
+    updateBegin();
+}
+
+// 低频采样（< 15 Hz）时块跨度可能超出 32 位 ns，把已写入的偏移降一级精度。
+// 这些偏移可能已经发布出去了：块还被快照引用时先复制一份再改
+void SampleStore::rescale(int k) {
+    if (m_tail.use_count() > 2) { // m_tail 与 m_live 各持一份
+        m_tail = std::make_shared<HotChunk>(*m_tail);
+        m_live.m_chunks.back() = m_tail;
+    }
+    for (int j = k / kBlock * kBlock; j < k; ++j) m_tail->off[j] >>= 1;
+    ++m_tail->blocks[k / kBlock].shift;
+}
+
+// 刚写满的块压缩追加到压缩段，然后换一个包含新段的映射
+void SampleStore::seal() {
+    if (m_cold->append(*m_tail)) {
+        m_live.m_cold = m_cold->mapping();
+    } else {
+        // 磁盘写不进去：丢掉已落盘的历史，从下一段重新开始，热数据不受影响
+        m_cold->reset(m_live.m_end);
+        m_live.m_cold.reset();
+    }
+    updateBegin();
+}
@@ -0,0 +1,402 @@
+#pragma once
+#include <QtGlobal>
+#include <QString>
+#include <memory>
+#include <vector>
+
+// 一行样本（导出 / 标签显示用）；存储本身是按列的 SampleStore
+struct PowerData {
+    float v; // 电压 (V)
+    float i; // 电流 (mA)
+    float p; // 功率 (mW)
+    quint64 t_ns = 0; // 时间戳 (ns, 上位机单调时钟，相对程序启动)
+};
+
+enum class Series { V = 0, I = 1, P = 2 };
+constexpr int kSeriesCount = 3;
+
+// 固定大小的桶（聚合金字塔、压缩段子块）的聚合：样本数由桶的大小决定，不另存
+struct BucketAgg {
+    float min, max;
+    double sum, sumSq;
+};
+
+// 一段样本某一列的聚合
+struct SeriesAgg {
+    float min = 0.0f;
+    float max = 0.0f;
+    double sum = 0.0;
+    double sumSq = 0.0;
+    qint64 n = 0; // 整段历史铺满屏幕时可以超过 int
+
+    void add(float v) {
+        if (n == 0) { min = max = v; }
+        else { min = qMin(min, v); max = qMax(max, v); }
+        sum += v;
+        sumSq += double(v) * v;
+        ++n;
+    }
+    // 一段连续样本：按下标模 4 分成四路各自累加，最后合并。
+    // 一条累加链在严格浮点下编译器不能重排，拆成四路后 x86 上用 SSE2 一次算四个；
+    // 其它平台按同样的分组逐个算，结果与 SSE2 相同（有 NaN 时和的 NaN 载荷可能不同）
+    void add(const float* p, int count);
+    void merge(const SeriesAgg& o) {
+        if (o.n == 0) return;
+        if (n == 0) { *this = o; return; }
+        min = qMin(min, o.min);
+        max = qMax(max, o.max);
+        sum += o.sum;
+        sumSq += o.sumSq;
+        n += o.n;
+    }
+    // 整桶并入，count 为桶内样本数
+    void merge(const BucketAgg& b, qint64 count) {
+        SeriesAgg o;
+        o.min = b.min; o.max = b.max; o.sum = b.sum; o.sumSq = b.sumSq;
+        o.n = count;
+        merge(o);
+    }
+};
+
+// 一段样本三列各自的聚合，一次遍历得到
+struct ChannelAgg {
+    SeriesAgg series[kSeriesCount];
+
+    const SeriesAgg& operator[](Series s) const { return series[int(s)]; }
+    void merge(const ChannelAgg& o) {
+        for (int s = 0; s < kSeriesCount; ++s) series[s].merge(o.series[s]);
+    }
+};
+
+// 时间戳分块的块头
+struct TimeBlock {
+    quint64 base = 0; // 块内第一个样本的时间戳
+    int shift = 0;    // 偏移单位 = 2^shift ns，块跨度超过 4.29 s 时才会 > 0
+};
+
+// 热数据的一块：kSize 个样本，按列存放，只追加
+//
+// 聚合桶在写满时一次算出，之前不写。
+// 已写入的样本、写满的时间块和写满的聚合桶之后不再修改，所以写入方可以一边往块尾追加，
+// 快照一边读块里已发布的部分。唯一的例外是低频采样时时间块降精度 (rescale)，
+// 这时写入方先复制一份再改 (copy-on-write)。
+struct HotChunk {
+    static constexpr int kSize = 4096;
+    static constexpr int kBlock = 64;                  // 时间戳分块大小
+    static constexpr int kBlocks = kSize / kBlock;
+    static constexpr int kFanout = 8;                  // 聚合金字塔每层的扇出
+    static constexpr int kLevels = 3;                  // 桶大小 64 / 512 / 4096，最小的桶 = 时间块
+    static constexpr int kAggCount = 64 + 8 + 1;
+
+    static constexpr int bucketSize(int level) { return kBlock << (3 * level); }
+    static constexpr int levelBase(int level) { return level == 0 ? 0 : levelBase(level - 1) + kSize / bucketSize(level - 1); }
+
+    quint64 first = 0; // 第一个样本的逻辑下标，kSize 的整数倍
+    float col[kSeriesCount][kSize];
+    quint32 off[kSize];
+    TimeBlock blocks[kBlocks];
+    BucketAgg aggs[kSeriesCount][kAggCount];
+
+    float value(Series s, quint64 idx) const { return col[int(s)][idx - first]; }
+    quint64 time(quint64 idx) const {
+        const int k = int(idx - first);
+        const TimeBlock& b = blocks[k / kBlock];
+        return b.base + (quint64(off[k]) << b.shift);
+    }
+    // 须已写满
+    const BucketAgg& bucket(Series s, int level, int k) const {
+        return aggs[int(s)][levelBase(level) + k / bucketSize(level)];
+    }
+    SeriesAgg total(Series s) const {
+        SeriesAgg out;
+        out.merge(bucket(s, kLevels - 1, 0), kSize);
+        return out;
+    }
+    // 第 k 个样本写入后调用：第 0 层桶写满时成段算出，再逐层合并出写满的上层桶
+    void fillBuckets(int k);
+
+    // 块内 [from, to) 的聚合，区间内的样本须已写入
+    SeriesAgg aggregate(Series s, quint64 from, quint64 to) const {
+        SeriesAgg out;
+        aggregate(from, to, int(s), int(s) + 1, &out);
+        return out;
+    }
+    // 三列一起：桶的选择只做一次
+    ChannelAgg aggregate(quint64 from, quint64 to) const {
+        ChannelAgg out;
+        aggregate(from, to, 0, kSeriesCount, out.series);
+        return out;
+    }
+    // 列 [s0, s1) 的聚合并入 out[0 .. s1 - s0)
+    void aggregate(quint64 from, quint64 to, int s0, int s1, SeriesAgg* out) const;
+};
+
+class ColdMapping;
+
+// 某一时刻历史的不可变快照
+//
+// 由 SampleStore::publish() 生成，持有当时全部热数据块和压缩段映射的引用。
+// 写入方之后退役的块、淘汰的段、文件映射区只在最后一个快照释放时才真正回收 (RCU)，
+// 所以快照可以在任意线程、任意长时间地读，不加锁也不拷贝样本。
+// 压缩段解码缓存是每线程一份，同一个快照也可以被多个线程同时读。
+class HistorySnapshot {
+public:
+    quint64 begin() const { return m_begin; }
+    quint64 end() const { return m_end; }
+    qint64 size() const { return qint64(m_end - m_begin); }
+    bool empty() const { return m_end == m_begin; }
+    quint64 hotBegin() const { return m_hotBegin; }
+    // 第几次 publish，一样说明内容没变
+    quint64 version() const { return m_version; }
+    // 来自哪个 SampleStore（进程内唯一），同一个 store 的快照下标可以互相比较
+    quint64 storeId() const { return m_storeId; }
+
+    // idx 为逻辑下标，须在 [begin(), end()) 内
+    float value(Series s, quint64 idx) const {
+        if (idx < m_hotBegin) return coldValue(s, idx);
+        return hot(idx)->value(s, idx);
+    }
+    quint64 time(quint64 idx) const {
+        if (idx < m_hotBegin) return coldTime(idx);
+        return hot(idx)->time(idx);
+    }
+    PowerData at(quint64 idx) const {
+        if (idx < m_hotBegin) return { coldValue(Series::V, idx), coldValue(Series::I, idx), coldValue(Series::P, idx), coldTime(idx) };
+        const HotChunk* c = hot(idx);
+        return { c->value(Series::V, idx), c->value(Series::I, idx), c->value(Series::P, idx), c->time(idx) };
+    }
+
+    // 逻辑下标 [from, to) 的聚合，须在 [begin(), end()) 内
+    SeriesAgg aggregate(Series s, quint64 from, quint64 to) const {
+        SeriesAgg out;
+        aggregate(from, to, int(s), int(s) + 1, &out);
+        return out;
+    }
+    ChannelAgg aggregate(quint64 from, quint64 to) const {
+        ChannelAgg out;
+        aggregate(from, to, 0, kSeriesCount, out.series);
+        return out;
+    }
+
+    // 从 idx 开始内存连续的一段，n 返回样本数（到块尾/段尾或 end()）；读取失败返回 nullptr
+    // 磁盘段的指针指向本线程的解码缓存，在本线程下一次读磁盘段之前有效
+    const float* chunk(Series s, quint64 idx, int& n) const;
+
+private:
+    friend class SampleStore;
+
+    const HotChunk* hot(quint64 idx) const { return m_chunks[size_t((idx - m_hotBegin) / HotChunk::kSize)].get(); }
+    void aggregate(quint64 from, quint64 to, int s0, int s1, SeriesAgg* out) const;
+    float coldValue(Series s, quint64 idx) const;
+    quint64 coldTime(quint64 idx) const;
+
+    quint64 m_begin = 0;
+    quint64 m_end = 0;
+    quint64 m_hotBegin = 0;
+    quint64 m_version = 0;
+    quint64 m_storeId = 0;
+    std::vector<std::shared_ptr<const HotChunk>> m_chunks; // 覆盖 [m_hotBegin, m_end)
+    std::shared_ptr<const ColdMapping> m_cold;
+};
+
+using HistorySnapshotPtr = std::shared_ptr<const HistorySnapshot>;
+
+// 快照上的一段只读视图：[first, last) 逻辑区间，下标相对 first
+// 持有快照的引用，可以随意拷贝、跨线程传递、长期保存
+// 落盘后历史可以有几天、上亿个样本，长度和相对下标都是 64 位
+class SampleView {
+public:
+    SampleView() = default;
+    explicit SampleView(HistorySnapshotPtr snap)
+        : SampleView(snap, snap ? snap->begin() : 0, snap ? snap->end() : 0) {}
+    SampleView(HistorySnapshotPtr snap, quint64 first, quint64 last)
+        : m_snap(std::move(snap)), m_first(first), m_last(last) {}
+
+    qint64 size() const { return qint64(m_last - m_first); }
+    bool empty() const { return m_last == m_first; }
+
+    float value(Series s, qint64 i) const { return m_snap->value(s, m_first + quint64(i)); }
+    quint64 time(qint64 i) const { return m_snap->time(m_first + quint64(i)); }
+    PowerData at(qint64 i) const { return m_snap->at(m_first + quint64(i)); }
+    PowerData back() const { return at(size() - 1); }
+
+    // 逻辑下标（与 SampleStore::begin/end 同一坐标系）
+    quint64 firstIndex() const { return m_first; }
+    quint64 lastIndex() const { return m_last; }
+    const HistorySnapshotPtr& snapshot() const { return m_snap; }
+
+    // 相对下标 [from, from + n)，越界部分截掉
+    SampleView subspan(qint64 from, qint64 n) const {
+        from = qBound<qint64>(0, from, size());
+        n = qBound<qint64>(0, n, size() - from);
+        return SampleView(m_snap, m_first + quint64(from), m_first + quint64(from + n));
+    }
+
+    // 按内存连续的片段遍历一列：f(const float* p, int n)
+    // 热数据每块一段，磁盘部分每个落盘段一段
+    template <typename F> inline void forEachChunk(Series s, F&& f) const;
+    // 三列同时按连续片段遍历：f(qint64 i, const float* const cols[kSeriesCount], int n)，
+    // i 为片段第一个样本的相对下标，cols 按 Series 排列；读不出来的磁盘段跳过
+    template <typename F> inline void forEachBlock(F&& f) const;
+
+    // 相对下标 [from, from + n) 的 min/max/sum/sumSq，走金字塔，与 n 的大小基本无关
+    SeriesAgg aggregate(Series s, qint64 from, qint64 n) const {
+        const SampleView sub = subspan(from, n);
+        return sub.empty() ? SeriesAgg() : m_snap->aggregate(s, sub.m_first, sub.m_last);
+    }
+    // 同上，三列一次算完
+    ChannelAgg aggregate(qint64 from, qint64 n) const {
+        const SampleView sub = subspan(from, n);
+        return sub.empty() ? ChannelAgg() : m_snap->aggregate(sub.m_first, sub.m_last);
+    }
+
+private:
+    HistorySnapshotPtr m_snap;
+    quint64 m_first = 0;
+    quint64 m_last = 0;
+};
+
+class ColdStore;
+
+// 每通道一份的按列历史缓冲（写入方）
+//
+// 热数据是若干个 HotChunk：V / I / P 各一个 float 数组，统计和绘图只遍历需要的那一列。
+// 时间戳按 64 个样本分块：块内存 32 位偏移，块头存 64 位基准和移位量。
+// 每列另有 min/max/sum/sumSq 金字塔：第 L 层每个桶覆盖 64 * 8^L 个样本，写满 64 个样本算一次，
+// 每样本约 1.3 字节。任意区间的聚合只需 O(8 * 层数) 次合并，加上两头不满一桶的零头
+// 成段计算 (SeriesAgg::add)，示波器缩到多远都按像素数计算。
+// 逻辑下标从 0 递增，clear 后也不回退；写满后整块退役最旧的数据。
+//
+// 每写满一块就压缩成一段 (ColdStore)，退役的块从压缩段读，逻辑下标、视图、聚合对两层透明。
+// 压缩段默认留在内存里，按字节预算淘汰最旧的段；enableSpill 之后改为追加到磁盘，
+// 历史长度只受磁盘限制。
+//
+// 线程模型：push / clear / publish 以及本类的读接口只在写入线程调用；
+// 其它线程通过 snapshot() / view() 拿不可变快照，写入方从不等读者，读者也从不等写入方。
+class SampleStore {
+public:
+    static constexpr int kDefaultCapacity = 1 << 14;
+    static constexpr int kBlock = HotChunk::kBlock;
+    static constexpr int kFanout = HotChunk::kFanout;
+    static constexpr int kSegment = HotChunk::kSize; // 热数据块 = 压缩段
+    static constexpr qint64 kDefaultCompressedBytes = qint64(8) << 20;
+
+    SampleStore();
+    // 热数据容量向上取整到整块，且不小于两块；compressedBytes 为不落盘时压缩段的内存预算
+    explicit SampleStore(int capacity, qint64 compressedBytes = kDefaultCompressedBytes);
+    ~SampleStore();
+
+    SampleStore(const SampleStore&) = delete;
+    SampleStore& operator=(const SampleStore&) = delete;
+
+    // 开启落盘，须在第一次 push 之前调用；失败时压缩段继续留在内存里
+    bool enableSpill(const QString& path, QString* error = nullptr);
+    bool spilling() const;
+
+    void push(float v, float i, float p, quint64 t_ns) {
+        const quint64 idx = m_live.m_end;
+        if (idx % kSegment == 0) startChunk(idx);
+
+        const int k = int(idx - m_tail->first);
+        const int blk = k / kBlock;
+        if (k % kBlock == 0) {
+            m_tail->blocks[blk].base = t_ns;
+            m_tail->blocks[blk].shift = 0;
+        }
+
+        // 块内时间戳只会比块头晚；乱序的一点点按块头算
+        const quint64 base = m_tail->blocks[blk].base;
+        const quint64 delta = (t_ns > base) ? t_ns - base : 0;
+        while ((delta >> m_tail->blocks[blk].shift) > 0xFFFFFFFFull) rescale(k);
+
+        HotChunk& w = *m_tail; // rescale 可能换了块
+        w.col[0][k] = v;
+        w.col[1][k] = i;
+        w.col[2][k] = p;
+        w.off[k] = quint32(delta >> w.blocks[blk].shift);
+
+        if ((k + 1) % kBlock == 0) w.fillBuckets(k);
+
+        m_live.m_end = idx + 1;
+        if (m_live.m_end % kSegment == 0) seal();
+    }
+
+    // 丢弃全部样本（包括磁盘段），逻辑下标从下一个整块继续
+    void clear();
+
+    // 把当前状态发布成快照；写入方每批写完调用一次
+    void publish();
+    // 最近一次发布的快照，任意线程可调用；从未发布过时返回空快照
+    HistorySnapshotPtr snapshot() const;
+    SampleView view() const { return SampleView(snapshot()); }
+
+    quint64 begin() const { return m_live.m_begin; }
+    quint64 end() const { return m_live.m_end; }
+    qint64 size() const { return m_live.size(); }
+    bool empty() const { return m_live.empty(); }
+    int capacity() const { return m_maxChunks * kSegment; }
+    // 压缩段占用的字节数（落盘时是文件里的，不占内存）
+    quint64 compressedBytes() const;
+    // 热数据的起点，之前的样本在压缩段里
+    quint64 hotBegin() const { return m_live.m_hotBegin; }
+    // 下一次 push 之后 begin() 的值：写满时最旧的块会退役，内存里的压缩段可能被淘汰。
+    // 落盘失败是预测不到的，这时 begin() 会跳得更远
+    quint64 nextBegin() const;
+
+    // 写入线程内直接读当前状态；idx 为逻辑下标，须在 [begin(), end()) 内
+    float value(Series s, quint64 idx) const { return m_live.value(s, idx); }
+    quint64 time(quint64 idx) const { return m_live.time(idx); }
+    PowerData at(quint64 idx) const { return m_live.at(idx); }
+    PowerData back() const { return at(end() - 1); }
+    SeriesAgg aggregate(Series s, quint64 from, quint64 to) const { return m_live.aggregate(s, from, to); }
+    ChannelAgg aggregate(quint64 from, quint64 to) const { return m_live.aggregate(from, to); }
+
+private:
+    void startChunk(quint64 first);
+    void rescale(int k);
+    void seal();
+    void updateBegin();
+
+    HistorySnapshot m_live;             // 写入方自己看到的最新状态，publish 时整体拷一份
+    std::shared_ptr<HotChunk> m_tail;   // 正在写的块，同时是 m_live.m_chunks.back()
+    HistorySnapshotPtr m_published;     // 只通过 std::atomic_load / atomic_store 访问
+    std::unique_ptr<ColdStore> m_cold;
+    int m_maxChunks = 0;
+};
+
+template <typename F>
+inline void SampleView::forEachChunk(Series s, F&& f) const {
+    quint64 idx = m_first;
+    while (idx < m_last) {
+        int n = 0;
+        const float* p = m_snap->chunk(s, idx, n);
+        if (!p) {
+            // 磁盘段读不出来：跳过，直接到热数据
+            if (idx >= m_snap->hotBegin()) break;
+            idx = m_snap->hotBegin();
+            continue;
+        }
+        n = int(qMin<quint64>(quint64(n), m_last - idx));
+        f(p, n);
+        idx += quint64(n);
+    }
+}
+
+template <typename F>
+inline void SampleView::forEachBlock(F&& f) const {
+    quint64 idx = m_first;
+    while (idx < m_last) {
+        const float* cols[kSeriesCount];
+        int n = 0;
+        // 三列在同一个块 / 同一个已解码段里，长度相同
+        for (int s = 0; s < kSeriesCount; ++s) cols[s] = m_snap->chunk(Series(s), idx, n);
+        if (!cols[0] || !cols[1] || !cols[2]) {
+            if (idx >= m_snap->hotBegin()) break;
+            idx = m_snap->hotBegin();
+            continue;
+        }
+        n = int(qMin<quint64>(quint64(n), m_last - idx));
+        f(qint64(idx - m_first), cols, n);
+        idx += quint64(n);
+    }
+}
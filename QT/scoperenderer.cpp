@@ -0,0 +1,286 @@
+#include "scoperenderer.h"
+#include <QCoreApplication>
+#include <QPainter>
+#include <QThread>
+#include <QThreadPool>
+#include <cmath>
+#include <algorithm> // for std::max
+
+QThreadPool* ScopeRenderer::pool() {
+    // 挂在 qApp 下：退出时线程池析构会等正在跑的渲染任务结束
+    static QThreadPool* p = [] {
+        auto* tp = new QThreadPool(QCoreApplication::instance());
+        tp->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return tp;
+    }();
+    return p;
+}
+
+static inline qint64 ringPos(qint64 c, qint64 ring) { return ((c % ring) + ring) % ring; }
+
+QImage ScopeRenderer::render(const ScopeFrame& frame) {
+    m_f = frame;
+    ensureGrid();
+    QImage img = m_grid; // 写时复制：下面画上去时才拷一份
+    if (m_f.view.size() >= 2 && m_f.offset < m_f.view.size()) {
+        QPainter painter(&img);
+        paint(painter);
+    } else {
+        m_last.valid = false;
+    }
+    m_f.view = SampleView(); // 画完就放掉快照，不拖住已退役的块
+    return img;
+}
+
+void ScopeRenderer::paint(QPainter &painter) {
+    m_right = m_f.view.lastIndex() - 1 - quint64(m_f.offset);
+    m_rightCol = colOf(m_right);
+
+    const Series order[kSeriesCount] = { Series::P, Series::I, Series::V };
+    const bool show[kSeriesCount] = { m_f.showV, m_f.showI, m_f.showP };
+    const QColor color[kSeriesCount] = { m_f.colorV, m_f.colorI, m_f.colorP };
+
+    // 可见区间三列一次聚合，量程和 RMS 都从这里取
+    qint64 first, n;
+    visibleRange(first, n);
+    m_visible = m_f.view.aggregate(first, n);
+
+    // 实时滚动时量程带回差：新量程仍落在 [0.5, 1] 倍旧量程内就沿用，迹线不用整幅重画
+    double need[kSeriesCount];
+    for (int s = 0; s < kSeriesCount; ++s) need[s] = visibleMax(Series(s));
+    bool full = !canScroll();
+    for (int s = 0; s < kSeriesCount && !full; ++s) {
+        if (show[s] && (need[s] > m_range[s] || need[s] < 0.5 * m_range[s])) full = true;
+    }
+
+    const int ringW = width() + kRingMargin;
+    if (full) {
+        std::copy(need, need + kSeriesCount, m_range);
+        const QSize ringSize = QSize(ringW, height()) * m_f.dpr;
+        if (m_traces.size() != ringSize || m_traces.devicePixelRatio() != m_f.dpr) {
+            m_traces = QImage(ringSize, QImage::Format_ARGB32_Premultiplied);
+            m_traces.setDevicePixelRatio(m_f.dpr);
+        }
+        m_traces.fill(Qt::transparent);
+        m_ringW = ringW;
+    }
+
+    {
+        QPainter tp(&m_traces);
+        tp.setRenderHint(QPainter::Antialiasing);
+        const qint64 c0 = full ? m_rightCol - width() + 1 : m_last.rightCol;
+        if (!full) clearColumns(tp, c0, m_rightCol);
+        buildColumns(c0, m_rightCol, show);
+        for (Series s : order) {
+            if (show[int(s)]) drawColumns(tp, s, color[int(s)], c0, m_rightCol);
+        }
+    }
+
+    m_last.valid = true;
+    m_last.store = m_f.view.snapshot()->storeId();
+    m_last.right = m_right;
+    m_last.rightCol = m_rightCol;
+    m_last.frame = m_f;
+    m_last.frame.view = SampleView();
+
+    compose(painter);
+    drawOverlay(painter);
+}
+
+bool ScopeRenderer::canScroll() const {
+    const ScopeFrame& o = m_last.frame;
+    return m_last.valid && m_f.offset == 0 && o.offset == 0 &&
+           m_last.store == m_f.view.snapshot()->storeId() &&
+           o.size == m_f.size && o.dpr == m_f.dpr && o.zoom == m_f.zoom &&
+           o.showV == m_f.showV && o.showI == m_f.showI && o.showP == m_f.showP &&
+           m_right >= m_last.right && m_last.right >= m_f.view.firstIndex() && // clear 之后下标会跳过旧数据
+           m_rightCol - m_last.rightCol < width();
+}
+
+void ScopeRenderer::ensureGrid() {
+    const QSize devSize = m_f.size * m_f.dpr;
+    if (m_grid.size() == devSize && m_grid.devicePixelRatio() == m_f.dpr) return;
+
+    m_grid = QImage(devSize, QImage::Format_ARGB32_Premultiplied);
+    m_grid.setDevicePixelRatio(m_f.dpr);
+    QPainter painter(&m_grid);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(QRect(QPoint(0, 0), m_f.size), Qt::black);
+    // 网格绘制
+    painter.setPen(QPen(QColor(60, 60, 60), 1, Qt::DotLine));
+    for (int x = width(); x > 0; x -= 50) painter.drawLine(x, 0, x, height());
+    for (int y = 0; y < height(); y += qMax(1, height() / 4)) painter.drawLine(0, y, width(), y);
+}
+
+// 环形缓冲里 [c0, c1] 列清成透明
+void ScopeRenderer::clearColumns(QPainter &p, qint64 c0, qint64 c1) {
+    p.save();
+    p.setRenderHint(QPainter::Antialiasing, false);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    for (qint64 c = c0; c <= c1;) {
+        const qint64 x = ringPos(c, m_ringW);
+        const qint64 len = qMin<qint64>(c1 - c + 1, m_ringW - x);
+        p.fillRect(QRectF(double(x), 0.0, double(len), height()), Qt::transparent);
+        c += len;
+    }
+    p.restore();
+}
+
+void ScopeRenderer::buildColumns(qint64 c0, qint64 c1, const bool show[kSeriesCount]) {
+    const quint64 F = m_f.view.firstIndex();
+    const double h = height();
+    double scale[kSeriesCount];
+    for (int s = 0; s < kSeriesCount; ++s) {
+        scale[s] = h / m_range[s];
+        m_lines[s].clear();
+        m_points[s].clear();
+    }
+    // 列 c 在环形缓冲里的 x：以 c0 所在的一圈为基准展开，超出的部分画的时候平移一圈再画一次
+    const qint64 base = c0 - ringPos(c0, m_ringW);
+    auto X = [&](qint64 c) { return double(c - base) + 0.5; };
+    auto toY = [&](int s, double val) { return qBound(0.0, h - val * scale[s], h); };
+
+    if (m_f.zoom < 1.0) {
+        // 一个像素覆盖多个样本：每列画该列全部样本 |值| 的最小-最大竖线，尖峰不会丢。
+        // 与上一列不重叠时把竖线延长到上一列的范围，包络连续，不需要斜线。
+        // 每列一次金字塔查询，三列一起取
+        bool havePrev = false;
+        double prevTop[kSeriesCount] = {}, prevBottom[kSeriesCount] = {};
+        for (qint64 c = c0 - 1; c <= c1; ++c) {
+            const quint64 a = qMax(firstSample(c), F);
+            const quint64 b = qMin(firstSample(c + 1), m_right + 1);
+            if (a >= b) { havePrev = false; continue; }
+            const ChannelAgg ag = m_f.view.aggregate(qint64(a - F), qint64(b - a));
+
+            for (int s = 0; s < kSeriesCount; ++s) {
+                if (!show[s]) continue;
+                const SeriesAgg& sa = ag.series[s];
+                double absLo, absHi;
+                if (sa.min >= 0) { absLo = sa.min; absHi = sa.max; }
+                else if (sa.max <= 0) { absLo = -sa.max; absHi = -sa.min; }
+                else { absLo = 0.0; absHi = std::max(-sa.min, sa.max); }
+
+                const double top = toY(s, absHi), bottom = toY(s, absLo);
+                if (c >= c0) {
+                    double y0 = havePrev ? qMin(top, prevBottom[s]) : top;
+                    double y1 = havePrev ? qMax(bottom, prevTop[s]) : bottom;
+                    if (y1 - y0 < 1.0) { y0 -= 0.5; y1 += 0.5; } // 平坦的一列也要有一点长度
+                    m_lines[s].emplace_back(X(c), y0, X(c), y1);
+                }
+                prevTop[s] = top;
+                prevBottom[s] = bottom;
+            }
+            havePrev = true;
+        }
+        return;
+    }
+
+    // 一个样本占一列或多列：画成台阶，每个样本一段水平线（首尾两点）。
+    // 按内存连续的片段同时读三列，不逐点查块
+    const quint64 first = qMax(sampleAt(c0 - 1), F);
+    const quint64 last = qMin(sampleAt(c1), m_right);
+    if (first > last) return;
+    m_f.view.subspan(qint64(first - F), qint64(last - first + 1)).forEachBlock(
+        [&](qint64 i, const float* const cols[kSeriesCount], int n) {
+            for (int j = 0; j < n; ++j) {
+                const quint64 idx = first + quint64(i + j);
+                const qint64 start = qMax(colOf(idx), c0 - 1);
+                const qint64 end = qMin(colOf(idx + 1) - 1, c1);
+                if (end < start) continue;
+                for (int s = 0; s < kSeriesCount; ++s) {
+                    if (!show[s]) continue;
+                    const double y = toY(s, std::abs(cols[s][j]));
+                    m_points[s].emplace_back(X(start), y);
+                    m_points[s].emplace_back(X(end), y);
+                }
+            }
+        });
+}
+
+void ScopeRenderer::drawColumns(QPainter &p, Series s, QColor color, qint64 c0, qint64 c1) {
+    const std::vector<QLineF>& lines = m_lines[int(s)];
+    const std::vector<QPointF>& points = m_points[int(s)];
+    if (lines.empty() && points.size() < 2) return;
+
+    p.setPen(QPen(color, 2));
+    // 坐标以 c0 所在的一圈为基准（见 buildColumns），跨过缓冲右边界的部分平移一圈再画。
+    // 只画进 [c0, c1] 这几列：从 c0 - 1 接过来的那一笔不会盖到已经画好的列上，
+    // 增量画出来的和整幅重画的逐像素一致
+    const double xMin = double(ringPos(c0, m_ringW)), xMax = xMin + double(c1 - c0 + 1);
+    for (double off : { -double(m_ringW), 0.0, double(m_ringW) }) {
+        if (xMax + off <= 0.0 || xMin + off >= m_ringW) continue;
+        p.save();
+        p.translate(off, 0.0);
+        p.setClipRect(QRectF(xMin, 0.0, xMax - xMin, height()));
+        if (!lines.empty()) p.drawLines(lines.data(), int(lines.size()));
+        else p.drawPolyline(points.data(), int(points.size()));
+        p.restore();
+    }
+}
+
+// 环形缓冲按屏幕顺序贴到网格上：最多两段
+void ScopeRenderer::compose(QPainter &p) {
+    const int w = width(), h = height();
+    const qreal d = m_f.dpr;
+    const int start = int(ringPos(m_rightCol - w + 1, m_ringW));
+    const int n1 = qMin(w, m_ringW - start);
+    p.drawImage(QRectF(0, 0, n1, h), m_traces, QRectF(start * d, 0, n1 * d, h * d));
+    if (n1 < w) p.drawImage(QRectF(n1, 0, w - n1, h), m_traces, QRectF(0, 0, (w - n1) * d, h * d));
+}
+
+void ScopeRenderer::drawOverlay(QPainter &painter) {
+    // 显示当前量程和缩放倍率
+    double rmsV = visibleRms(Series::V);
+    double rmsI = visibleRms(Series::I);
+    double rmsP = visibleRms(Series::P);
+
+    painter.setPen(Qt::white);
+    painter.drawText(10, 20,
+                     QString("RMS: V=%1 V  I=%2 mA  P=%3 mW")
+                         .arg(rmsV, 0, 'f', 3)
+                         .arg(rmsI, 0, 'f', 1)
+                         .arg(rmsP, 0, 'f', 1)
+                     );
+
+    // 显示横轴缩放信息
+    painter.drawText(width() - 100, 20, QString("Zoom: x%1").arg(m_f.zoom, 0, 'g', 3));
+
+    // 触发点：迹线叠在网格上之后再画，不进环形缓冲
+    if (m_f.marker >= 0 && quint64(m_f.marker) <= m_right) {
+        const qint64 x = colOf(quint64(m_f.marker)) - (m_rightCol - width() + 1);
+        if (x >= 0 && x < width()) {
+            painter.setPen(QPen(QColor(255, 255, 255, 160), 1, Qt::DashLine));
+            painter.drawLine(QLineF(x + 0.5, 0, x + 0.5, height()));
+            painter.drawText(int(x) + 4, height() - 6, "T");
+        }
+    }
+}
+
+quint64 ScopeRenderer::firstSample(qint64 col) const {
+    if (col <= 0) return 0;
+    quint64 idx = quint64(std::ceil(double(col) / m_f.zoom));
+    // 浮点除法可能差一个，按 colOf 校正
+    while (idx > 0 && colOf(idx - 1) >= col) --idx;
+    while (colOf(idx) < col) ++idx;
+    return idx;
+}
+
+// 屏幕内可见的样本区间 [first, first + n)，相对 view
+void ScopeRenderer::visibleRange(qint64 &first, qint64 &n) const {
+    const qint64 leftCol = m_rightCol - width() + 1;
+    const quint64 a = qMax(m_f.zoom >= 1.0 ? sampleAt(leftCol) : firstSample(leftCol), m_f.view.firstIndex());
+    first = qint64(a - m_f.view.firstIndex());
+    n = (a <= m_right) ? qint64(m_right - a + 1) : 0;
+}
+
+// 当前视图内数据的最大值（金字塔聚合，不会漏掉尖峰）
+double ScopeRenderer::visibleMax(Series s) const {
+    const SeriesAgg& a = m_visible[s];
+    double maxVal = (a.n > 0) ? std::max(std::abs(a.min), std::abs(a.max)) : 0.0;
+    if(maxVal<0.1) maxVal = 1.0;
+    return maxVal * 1.2;
+}
+double ScopeRenderer::visibleRms(Series s) const {
+    const SeriesAgg& a = m_visible[s];
+    return (a.n > 0) ? std::sqrt(a.sumSq / a.n) : 0.0;
+}
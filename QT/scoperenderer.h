@@ -0,0 +1,98 @@
+#pragma once
+#include <QColor>
+#include <QImage>
+#include <QLineF>
+#include <QPointF>
+#include <QSize>
+#include <cmath>
+#include <vector>
+#include "samplestore.h"
+
+class QPainter;
+class QThreadPool;
+
+// 一帧示波器画面的全部输入，按值交给渲染线程
+struct ScopeFrame {
+    SampleView view;   // 历史快照，渲染期间写入方继续写也不受影响
+    qint64 offset = 0;
+    double zoom = 1.0;
+    QSize size;
+    qreal dpr = 1.0;
+    bool showV = true, showI = true, showP = true;
+    QColor colorV, colorI, colorP;
+    qint64 marker = -1;  // 触发点的逻辑下标，画一条竖线；-1 不画
+
+    // 输入没变就不用重画
+    bool sameAs(const ScopeFrame& o) const {
+        return view.snapshot() == o.view.snapshot() && view.firstIndex() == o.view.firstIndex() &&
+               view.lastIndex() == o.view.lastIndex() &&
+               offset == o.offset && zoom == o.zoom && size == o.size && dpr == o.dpr &&
+               showV == o.showV && showI == o.showI && showP == o.showP && marker == o.marker;
+    }
+};
+
+// 把一帧画到 QImage 上，可在任意线程调用
+// 每个示波器一个实例，同一时刻只被一个渲染任务使用，缓冲跨帧复用。
+//
+// 像素列按样本的绝对逻辑下标对齐（第 c 列 = floor(idx * zoom) == c 的样本），
+// 实时模式 (offset 0) 来了新样本，画面正好整列左移。迹线画在一个按列环形使用的后备缓冲里，
+// 只清掉并重画新增的列（外加上一帧最右那列，它可能还没收满），网格单独缓存，
+// 每帧的光栅化开销与新数据量成正比，与控件宽度无关。
+// 量程、尺寸、缩放、开关变了，或者在回看历史时，整幅重画。
+class ScopeRenderer {
+public:
+    QImage render(const ScopeFrame& frame);
+
+    // 所有示波器共用的渲染线程池，给 GUI 线程留一个核
+    static QThreadPool* pool();
+
+private:
+    // 环形缓冲比屏幕多几列，最右一列抗锯齿溢出的像素不会出现在最左边
+    static constexpr int kRingMargin = 4;
+
+    int width() const { return m_f.size.width(); }
+    int height() const { return m_f.size.height(); }
+
+    qint64 colOf(quint64 idx) const { return qint64(std::floor(double(idx) * m_f.zoom)); }
+    // 第一个 colOf(idx) >= col 的样本
+    quint64 firstSample(qint64 col) const;
+    // 第 col 列显示的样本：zoom >= 1 时是这一列所在台阶的样本
+    quint64 sampleAt(qint64 col) const { const quint64 f = firstSample(col + 1); return f > 0 ? f - 1 : 0; }
+
+    void paint(QPainter &painter);
+    void visibleRange(qint64 &first, qint64 &n) const;
+    // 量程 / RMS 都来自同一次可见区间聚合 m_visible
+    double visibleMax(Series s) const;
+    double visibleRms(Series s) const;
+
+    void ensureGrid();
+    bool canScroll() const;
+    void clearColumns(QPainter &p, qint64 c0, qint64 c1);
+    // 一遍扫过 [c0, c1] 列（从 c0 - 1 列接上），同时生成所有显示中迹线的线段 / 折线
+    void buildColumns(qint64 c0, qint64 c1, const bool show[kSeriesCount]);
+    // 把 buildColumns 生成的一条迹线画进环形缓冲
+    void drawColumns(QPainter &p, Series s, QColor color, qint64 c0, qint64 c1);
+    void compose(QPainter &p);
+    void drawOverlay(QPainter &p);
+
+    ScopeFrame m_f;
+    quint64 m_right = 0;      // 最右边显示的样本（绝对下标）
+    qint64 m_rightCol = 0;
+    double m_range[kSeriesCount] = {};
+    ChannelAgg m_visible;     // 屏幕内样本的聚合，每帧一次
+
+    QImage m_grid;            // 网格底图，尺寸变了才重画
+    QImage m_traces;          // 迹线环形后备缓冲：第 c 列在 x = c mod m_ringW
+    int m_ringW = 0;
+
+    struct LastFrame {
+        bool valid = false;
+        quint64 store = 0;
+        quint64 right = 0;
+        qint64 rightCol = 0;
+        ScopeFrame frame;     // 只比较参数，view 不保留
+    } m_last;
+
+    std::vector<QPointF> m_points[kSeriesCount]; // 点/线数组跨帧复用
+    std::vector<QLineF> m_lines[kSeriesCount];
+};
@@ -1,71 +1,236 @@
 #include "serialworker.h"
+#include "bytesource.h"
+#include "powerframe.h"
+#include <charconv>
+#include <cstring>
 
-SerialWorker::SerialWorker(QObject* parent) : QObject(parent),
-    m_re(R"(CH:(\d)\s+V=\s*([-\d\.]+)\s+V\s+\|\s+I=\s*([-\d\.]+)\s+A\s+\|\s+P=\s*([-\d\.]+)\s+W)")
-{
+// 既无换行也无帧头的垃圾数据最多保留这么多字节（也是单行最大长度）
+static constexpr int kMaxPendingBytes = 4096;
+// 接收环形缓冲容量，需大于一次 USB-CDC 突发
+static constexpr int kRxCapacity = 1 << 16;
+
+// ---- 文本行解析：CH:<n> V=<num> V | I=<num> A | P=<num> W
+// 与固件 sprintf 格式一一对应，全程不分配内存
+namespace {
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+// \s+ : 至少一个空白
+inline bool spaces(const char*& p, const char* end) {
+    const char* q = skipSpaces(p, end);
+    if (q == p) return false;
+    p = q;
+    return true;
+}
+
+inline bool literal(const char*& p, const char* end, const char* lit) {
+    size_t n = std::strlen(lit);
+    if ((size_t)(end - p) < n || std::memcmp(p, lit, n) != 0) return false;
+    p += n;
+    return true;
+}
+
+// [-\d\.]+ ，整个 token 必须是合法浮点数
+inline bool number(const char*& p, const char* end, float& out) {
+    const char* tok = p;
+    while (p < end && (*p == '-' || *p == '.' || (*p >= '0' && *p <= '9'))) ++p;
+    if (p == tok) return false;
+    auto r = std::from_chars(tok, p, out);
+    return r.ec == std::errc() && r.ptr == p;
+}
+
+// <label>=\s*<num>\s+<unit>
+inline bool field(const char*& p, const char* end, const char* label, const char* unit, float& out) {
+    if (!literal(p, end, label)) return false;
+    p = skipSpaces(p, end);
+    return number(p, end, out) && spaces(p, end) && literal(p, end, unit);
+}
+
+inline bool separator(const char*& p, const char* end) {
+    return spaces(p, end) && literal(p, end, "|") && spaces(p, end);
 }
 
-void SerialWorker::openPort(const QString& portName, int baud) {
-    if (m_serial.isOpen()) m_serial.close();
+inline bool startsWith(const char* p, const char* end, const char* lit) {
+    size_t n = std::strlen(lit);
+    return (size_t)(end - p) >= n && std::memcmp(p, lit, n) == 0;
+}
 
-    m_serial.setPortName(portName);
-    m_serial.setBaudRate(baud);
-    m_serial.setDataBits(QSerialPort::Data8);
-    m_serial.setParity(QSerialPort::NoParity);
-    m_serial.setStopBits(QSerialPort::OneStop);
-    m_serial.setFlowControl(QSerialPort::NoFlowControl);
+} // namespace
+
+SerialWorker::SerialWorker(QObject* parent, int ringCapacity) : QObject(parent),
+    m_rx(kRxCapacity),
+    m_ring(ringCapacity)
+{
+}
 
-    if (!m_serial.open(QIODevice::ReadOnly)) {
-        emit errorOccured("无法打开串口：" + m_serial.errorString());
+void SerialWorker::openSource(const QString& spec, int baud) {
+    closeSource();
+
+    m_source = ByteSource::create(spec, baud, this);
+    if (!m_source->open()) {
+        emit errorOccured(m_source->errorString());
         emit connectedChanged(false);
+        delete m_source;
+        m_source = nullptr;
         return;
     }
 
-    connect(&m_serial, &QSerialPort::readyRead, this, &SerialWorker::onReadyRead, Qt::DirectConnection);
+    connect(m_source, &ByteSource::readyRead, this, &SerialWorker::onReadyRead, Qt::DirectConnection);
+    connect(m_source, &ByteSource::finished, this, &SerialWorker::onSourceFinished, Qt::DirectConnection);
+    emit logLine("[数据源] " + m_source->description());
     emit connectedChanged(true);
 }
 
 void SerialWorker::closePort() {
-    if (m_serial.isOpen()) m_serial.close();
+    closeSource();
     emit connectedChanged(false);
 }
 
+void SerialWorker::closeSource() {
+    if (m_source) {
+        m_source->close();
+        m_source->deleteLater();
+        m_source = nullptr;
+    }
+    m_rx.clear();
+    m_clockSync.reset();
+}
+
+void SerialWorker::onSourceFinished() {
+    emit logLine("[数据源] 已结束：" + (m_source ? m_source->description() : QString()));
+}
+
 void SerialWorker::onReadyRead() {
-    m_buf += m_serial.readAll();
+    if (!m_source) return;
 
+    // 直接读进环形缓冲的空闲区，不经过 QByteArray；每次 read 后立即取时间戳
     while (true) {
-        int pos = m_buf.indexOf('\n');
-        if (pos < 0) break;
-        QByteArray one = m_buf.left(pos);
-        m_buf.remove(0, pos + 1);
+        int span = 0;
+        char* dst = m_rx.writeSpan(span);
+        qint64 n = m_source->read(dst, span);
+        if (n <= 0) break;
+        const qint64 now = monotonicNs();
+        m_rx.commit(int(n));
+        processBuffer(now);
+    }
+}
 
-        QString line = QString::fromUtf8(one).trimmed();
-        if (line.isEmpty()) continue;
+void SerialWorker::feed(const char* data, qint64 n) {
+    const qint64 now = monotonicNs();
+
+    while (n > 0) {
+        int span = 0;
+        char* dst = m_rx.writeSpan(span);
+        const int k = int(qMin<qint64>(span, n));
+        std::memcpy(dst, data, size_t(k));
+        m_rx.commit(k);
+        processBuffer(now);
+        data += k;
+        n -= k;
+    }
+}
+
+qint64 SerialWorker::nextNewline() {
+    if (m_nextNl != ByteRing::npos && quint64(m_nextNl) >= m_rx.begin()) return m_nextNl;
+
+    // 已扫描过的区间不再重复扫描，保证整体线性
+    m_nextNl = m_rx.find('\n', qMax(m_nlScanned, m_rx.begin()));
+    m_nlScanned = (m_nextNl != ByteRing::npos) ? quint64(m_nextNl) + 1 : m_rx.end();
+    return m_nextNl;
+}
+
+qint64 SerialWorker::nextHeader() {
+    if (m_nextHdr != ByteRing::npos && quint64(m_nextHdr) >= m_rx.begin()) return m_nextHdr;
+
+    m_nextHdr = m_rx.findPair(PowerFrame::kHeaderBytes[0], PowerFrame::kHeaderBytes[1],
+                              qMax(m_hdrScanned, m_rx.begin()));
+    // 最后一个字节可能是半个帧头，下次从它开始
+    m_hdrScanned = (m_nextHdr != ByteRing::npos) ? quint64(m_nextHdr) + 1
+                                                 : qMax(m_rx.begin(), m_rx.end() - 1);
+    return m_nextHdr;
+}
+
+void SerialWorker::processBuffer(qint64 now) {
+    char scratch[kMaxPendingBytes]; // 跨越回绕的行/帧拷贝到这里
+
+    while (true) {
+        const quint64 b = m_rx.begin();
+        qint64 pos = nextNewline();
+        qint64 hdr = nextHeader();
+
+        // 二进制帧：帧头在下一个换行之前
+        if (hdr != ByteRing::npos && (pos == ByteRing::npos || hdr < pos)) {
+            m_rx.consumeTo(quint64(hdr)); // 帧头前的残缺文本丢弃
+            if (m_rx.size() < PowerFrame::kSize) break; // 等待剩余字节
+
+            ParsedSample s;
+            if (tryDecodeFrame(m_rx.contiguous(quint64(hdr), PowerFrame::kSize, scratch), s)) {
+                m_rx.consumeTo(quint64(hdr) + PowerFrame::kSize);
+                s.t_ns = m_clockSync.map(s.devTs, now);
+                m_ring.push(s); // 满了计入 dropped，不阻塞
+            } else {
+                // CRC 错误或数据中的伪帧头：跳过 1 字节重新同步
+                m_rx.consumeTo(quint64(hdr) + 1);
+            }
+            continue;
+        }
+
+        if (pos == ByteRing::npos) break;
+        const int len = int(quint64(pos) - b);
+        m_rx.consumeTo(quint64(pos) + 1);
+        if (len > kMaxPendingBytes) continue; // 超长垃圾行
+
+        const char* e0 = m_rx.contiguous(b, len, scratch);
+        const char* e = e0 + len;
 
         ParsedSample s;
-        if (tryParse(line, s)) {
-            emit sampleReady(s);
+        if (tryParse(e0, e, s)) {
+            s.t_ns = now;
+            m_ring.push(s);
         } else {
             // 启动信息/错误信息可以选择性发到 UI 日志（低频）
-            if (line.startsWith("OK:") || line.startsWith("ERR:") || line.startsWith("System")) {
-                emit logLine(line);
+            const char* t = skipSpaces(e0, e);
+            if (startsWith(t, e, "OK:") || startsWith(t, e, "ERR:") || startsWith(t, e, "System")) {
+                emit logLine(QString::fromUtf8(t, e - t).trimmed());
             }
         }
     }
+
+    // 保留末尾 1 字节：可能是被截断的帧头
+    if (m_rx.size() > kMaxPendingBytes) m_rx.consumeTo(m_rx.end() - 1);
 }
 
-bool SerialWorker::tryParse(const QString& line, ParsedSample& out) {
-    auto match = m_re.match(line);
-    if (!match.hasMatch()) return false;
+bool SerialWorker::tryParse(const char* begin, const char* end, ParsedSample& out) {
+    const char* p = skipSpaces(begin, end);
+
+    if (!literal(p, end, "CH:")) return false;
+    int ch = 0;
+    auto r = std::from_chars(p, end, ch);
+    if (r.ec != std::errc() || r.ptr == p || ch < 1 || ch > kMaxChannelNo) return false;
+    p = r.ptr;
 
-    bool ok=false;
-    int ch = match.captured(1).toInt(&ok);
-    if (!ok || (ch!=1 && ch!=2)) return false;
+    float v, i_a, p_w;
+    if (!spaces(p, end) || !field(p, end, "V=", "V", v)) return false;
+    if (!separator(p, end) || !field(p, end, "I=", "A", i_a)) return false;
+    if (!separator(p, end) || !field(p, end, "P=", "W", p_w)) return false;
+    if (skipSpaces(p, end) != end) return false;
+
+    out = { ch, v, i_a * 1000.0f, p_w * 1000.0f };
+    return true;
+}
 
-    float v = match.captured(2).toFloat();
-    float i_ma = match.captured(3).toFloat() * 1000.0f;
-    float p_mw = match.captured(4).toFloat() * 1000.0f;
+bool SerialWorker::tryDecodeFrame(const char* p, ParsedSample& out) {
+    PowerFrame::Frame f;
+    if (!PowerFrame::decode(p, f)) return false;
+    if (f.channel < 1) return false;
 
-    out = { ch, v, i_ma, p_mw };
+    out = { f.channel, f.v, f.i, f.p };
+    out.devTs = f.timestamp;
+    out.hasDevTs = true;
     return true;
 }
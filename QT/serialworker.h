@@ -1,38 +1,73 @@
 #pragma once
 #include <QObject>
-#include <QSerialPort>
-#include <QRegularExpression>
+#include "bytering.h"
+#include "spscring.h"
+#include "clocksync.h"
+
+class ByteSource;
 
 struct ParsedSample {
-    int ch;
+    int ch;  // 设备上的通道号 1..255
     float v; // V
     float i; // mA
     float p; // mW
+    // 主机单调时钟 monotonicNs()：文本行为 IO 线程读到数据的时刻，
+    // 带设备时间戳的帧为经 ClockSync 对齐后的采样时刻
+    qint64 t_ns = 0;
+    quint32 devTs = 0;     // 设备时间戳 (ms)，仅二进制帧
+    bool hasDevTs = false;
 };
 Q_DECLARE_METATYPE(ParsedSample)
 
+// IO 线程 -> GUI 线程的样本队列，GUI 每次刷新时取空
+using SampleRing = SpscRing<ParsedSample>;
+
 class SerialWorker : public QObject {
     Q_OBJECT
 public:
-    explicit SerialWorker(QObject* parent=nullptr);
+    static constexpr int kDefaultRingCapacity = 1 << 16;
+    static constexpr int kMaxChannelNo = 255; // 与 PowerFrame 的 u8 通道号一致
+
+    explicit SerialWorker(QObject* parent=nullptr, int ringCapacity=kDefaultRingCapacity);
+
+    // 线程安全：GUI 线程作为唯一消费者 drain()
+    SampleRing& ring() { return m_ring; }
+
+    // 喂入原始字节，与 onReadyRead 走同一条解析路径（回放 / 基准测试用）
+    void feed(const char* data, qint64 n);
+
+    // 直接解析原始字节 [begin, end)，不含换行
+    static bool tryParse(const char* begin, const char* end, ParsedSample& out);
+    // p 指向完整的 PowerFrame::kSize 字节
+    static bool tryDecodeFrame(const char* p, ParsedSample& out);
 
 public slots:
-    void openPort(const QString& portName, int baud);
+    // spec 见 ByteSource::create：串口名 / file: / pty: / tcp:
+    void openSource(const QString& spec, int baud);
     void closePort();
 
 signals:
-    void sampleReady(const ParsedSample& s);
     void logLine(const QString& s);
     void connectedChanged(bool ok);
     void errorOccured(const QString& s);
 
 private slots:
     void onReadyRead();
+    void onSourceFinished();
 
 private:
-    bool tryParse(const QString& line, ParsedSample& out);
+    void closeSource();
+    void processBuffer(qint64 now);
+    qint64 nextNewline();
+    qint64 nextHeader();
 
-    QSerialPort m_serial;
-    QByteArray m_buf;
-    QRegularExpression m_re;
+    ByteSource* m_source = nullptr;
+    ByteRing m_rx;
+    // 缓存下一个换行/帧头的位置及已扫描到的位置，避免重复扫描
+    qint64 m_nextNl = ByteRing::npos;
+    quint64 m_nlScanned = 0;
+    qint64 m_nextHdr = ByteRing::npos;
+    quint64 m_hdrScanned = 0;
+    ClockSync m_clockSync; // 设备时钟对齐，换数据源时重置
+    SampleRing m_ring;
 };
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 单生产者/单消费者无锁环形队列
+// 生产者 (IO 线程) 只调用 push()，消费者 (GUI 线程) 只调用 drain()。
+// 满了直接丢弃新样本并计数，push 永不阻塞、永不分配内存。
+template <typename T>
+class SpscRing {
+public:
+    // 容量向上取整到 2 的幂
+    explicit SpscRing(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_slots.resize(cap);
+        m_mask = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // ---- Producer
+    bool push(const T& v) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail > m_mask) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail > m_mask) {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_slots[head & m_mask] = v;
+        m_head.store(head + 1, std::memory_order_release);
+
+        const size_t used = head + 1 - m_cachedTail; // 上界估计，只偏大不偏小
+        if (used > m_highWater.load(std::memory_order_relaxed))
+            m_highWater.store(used, std::memory_order_relaxed);
+        return true;
+    }
+
+    // ---- Consumer: 对每个样本调用 f(const T&)，返回取出的个数
+    template <typename F>
+    size_t drain(F&& f, size_t maxItems = SIZE_MAX) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        size_t n = head - tail;
+        if (n > maxItems) n = maxItems;
+        for (size_t k = 0; k < n; ++k) f(m_slots[(tail + k) & m_mask]);
+        m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // ---- Stats (任意线程可读)
+    size_t capacity() const { return m_mask + 1; }
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    size_t highWater() const { return m_highWater.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> m_slots;
+    size_t m_mask = 0;
+
+    alignas(64) std::atomic<size_t> m_head{0}; // 下一个写位置 (producer)
+    size_t m_cachedTail = 0;                   // producer 私有
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<size_t> m_highWater{0};
+
+    alignas(64) std::atomic<size_t> m_tail{0}; // 下一个读位置 (consumer)
+};
@@ -0,0 +1,347 @@
+// PowerSim：多通道 INA226 设备模拟器，用于无硬件压测上位机数据通路
+//
+// 输出与 MCU/main.c 完全一致的文本行或二进制 PowerFrame，写到伪终端 / TCP / 文件。
+// 示例：
+//   PowerSim --pty --channels 8 --rate 1000 --format binary
+//     -> 打印 slave 路径，ProPowerMonitor 里输入 pty:/dev/pts/N 连接
+//   PowerSim --tcp 5555 --channels 64 --rate 10000
+//     -> ProPowerMonitor 里输入 tcp:127.0.0.1:5555
+//   PowerSim --file capture.bin --duration 60 --format binary
+//     -> 尽快生成 60 秒数据，可用 file:capture.bin?rate=... 回放
+
+#include "../powerframe.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// 待发送数据上限，超过即视为下游跟不上，丢弃并计数（模拟 UART 溢出）
+static constexpr qint64 kMaxPendingBytes = 4 * 1024 * 1024;
+
+struct SimConfig {
+    int channels = 2;
+    double rateHz = 20.0;       // 每通道采样率
+    bool binary = false;
+    double noiseMa = 0.5;       // 电流噪声标准差 (mA)
+    double stepPeriodS = 0.0;   // 阶跃负载周期，0 关闭
+    double stepMa = 200.0;
+    double spikeIntervalS = 0.0; // 尖峰间隔，0 关闭
+    double spikeMa = 1500.0;
+    int spikeLen = 3;           // 每次尖峰持续的样本数
+    qint64 byteRate = 0;        // 链路带宽上限 (B/s)，0 不限
+    double durationS = 0.0;     // 0 一直运行
+};
+
+// ---------------- Signal model ----------------
+
+class SignalModel {
+public:
+    explicit SignalModel(const SimConfig& cfg) : m_cfg(cfg), m_rng(12345), m_spikeLeft(cfg.channels, 0) {}
+
+    // 生成第 n 个采样时刻（所有通道）的数据，追加到 out
+    void generate(quint64 n, QByteArray& out) {
+        const double t = double(n) / m_cfg.rateHz;
+        const quint32 tsMs = quint32(t * 1000.0);
+
+        for (int ch = 0; ch < m_cfg.channels; ++ch) {
+            double i_ma = 100.0 + 25.0 * ch;
+            if (m_cfg.stepPeriodS > 0.0 && std::fmod(t + 0.1 * ch, m_cfg.stepPeriodS) >= m_cfg.stepPeriodS / 2)
+                i_ma += m_cfg.stepMa;
+            if (m_cfg.spikeIntervalS > 0.0) {
+                const quint64 every = qMax<quint64>(1, quint64(m_cfg.spikeIntervalS * m_cfg.rateHz));
+                if ((n + quint64(ch) * 7) % every == 0) m_spikeLeft[ch] = m_cfg.spikeLen;
+                if (m_spikeLeft[ch] > 0) { i_ma += m_cfg.spikeMa; --m_spikeLeft[ch]; }
+            }
+            i_ma += m_noise(m_rng) * m_cfg.noiseMa;
+
+            // 12 V 源，0.2 Ω 内阻
+            double v = 12.0 - 0.2 * i_ma / 1000.0 + m_noise(m_rng) * 0.002;
+            // 与 INA226 一致的量化：总线电压 1.25 mV，电流 0.1 mA
+            v = std::round(v / 0.00125) * 0.00125;
+            i_ma = std::round(i_ma / 0.1) * 0.1;
+            double p_mw = v * i_ma;
+
+            if (m_cfg.binary) {
+                PowerFrame::Frame f{ quint8(ch + 1), tsMs, float(v), float(i_ma), float(p_mw) };
+                char buf[PowerFrame::kSize];
+                PowerFrame::encode(f, buf);
+                out.append(buf, PowerFrame::kSize);
+            } else {
+                char line[96];
+                int len = std::snprintf(line, sizeof(line), "CH:%d V=%.3f V | I=%.4f A | P=%.4f W\r\n",
+                                        ch + 1, v, i_ma / 1000.0, p_mw / 1000.0);
+                out.append(line, len);
+            }
+        }
+    }
+
+private:
+    SimConfig m_cfg;
+    std::mt19937 m_rng;
+    std::normal_distribution<double> m_noise{0.0, 1.0};
+    std::vector<int> m_spikeLeft;
+};
+
+// ---------------- Sinks ----------------
+
+class Sink {
+public:
+    virtual ~Sink() = default;
+    // 返回实际写出的字节数，写不动时返回 0
+    virtual qint64 write(const char* data, qint64 n) = 0;
+};
+
+class FileSink : public Sink {
+public:
+    explicit FileSink(const QString& path) : m_file(path) {}
+    bool open() { return m_file.open(QIODevice::WriteOnly | QIODevice::Truncate); }
+    qint64 write(const char* data, qint64 n) override { return m_file.write(data, n); }
+private:
+    QFile m_file;
+};
+
+#ifdef Q_OS_UNIX
+class PtySink : public Sink {
+public:
+    ~PtySink() override {
+        if (m_slave >= 0) ::close(m_slave);
+        if (m_master >= 0) ::close(m_master);
+    }
+    bool open() {
+        m_master = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (m_master < 0 || ::grantpt(m_master) != 0 || ::unlockpt(m_master) != 0) return false;
+        m_path = QString::fromLocal8Bit(::ptsname(m_master));
+        // 自己持有 slave，读端重连时不会丢失 pty
+        m_slave = ::open(m_path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+        termios tio;
+        if (::tcgetattr(m_slave, &tio) == 0) {
+            ::cfmakeraw(&tio);
+            ::tcsetattr(m_slave, TCSANOW, &tio);
+        }
+        ::fcntl(m_master, F_SETFL, ::fcntl(m_master, F_GETFL) | O_NONBLOCK);
+        return true;
+    }
+    QString path() const { return m_path; }
+    qint64 write(const char* data, qint64 n) override {
+        ssize_t w = ::write(m_master, data, size_t(n));
+        return (w > 0) ? w : 0;
+    }
+private:
+    int m_master = -1;
+    int m_slave = -1;
+    QString m_path;
+};
+#endif
+
+class TcpSink : public Sink {
+public:
+    bool listen(quint16 port) {
+        QObject::connect(&m_server, &QTcpServer::newConnection, [this]() {
+            while (QTcpSocket* s = m_server.nextPendingConnection()) {
+                QObject::connect(s, &QTcpSocket::disconnected, s, &QObject::deleteLater);
+                m_clients.push_back(s);
+            }
+        });
+        return m_server.listen(QHostAddress::LocalHost, port);
+    }
+    qint64 write(const char* data, qint64 n) override {
+        qint64 best = 0;
+        for (auto it = m_clients.begin(); it != m_clients.end();) {
+            QTcpSocket* s = *it;
+            if (s->state() != QAbstractSocket::ConnectedState) { it = m_clients.erase(it); continue; }
+            // socket 自带缓冲，积压过多时当作写不动
+            if (s->bytesToWrite() < kMaxPendingBytes) best = qMax(best, s->write(data, n));
+            ++it;
+        }
+        return m_clients.empty() ? n : best; // 无客户端时直接丢弃
+    }
+private:
+    QTcpServer m_server;
+    std::vector<QTcpSocket*> m_clients;
+};
+
+// ---------------- Driver ----------------
+
+class Simulator : public QObject {
+public:
+    Simulator(const SimConfig& cfg, Sink* sink, bool realtime)
+        : m_cfg(cfg), m_sink(sink), m_model(cfg), m_realtime(realtime)
+    {
+        connect(&m_timer, &QTimer::timeout, this, [this]() { tick(); });
+    }
+
+    void start() {
+        m_clock.start();
+        m_timer.start(m_realtime ? 1 : 0);
+    }
+
+private:
+    void tick() {
+        const double elapsedS = m_realtime ? m_clock.nsecsElapsed() / 1e9
+                                           : double(m_sampleIdx + 4096) / m_cfg.rateHz;
+        double targetS = elapsedS;
+        if (m_cfg.durationS > 0.0) targetS = qMin(targetS, m_cfg.durationS);
+        const quint64 due = quint64(targetS * m_cfg.rateHz);
+
+        while (m_sampleIdx < due) m_model.generate(m_sampleIdx++, m_pending);
+        m_generatedSamples = m_sampleIdx * quint64(m_cfg.channels);
+
+        flush();
+        report(false);
+
+        if (m_cfg.durationS > 0.0 && targetS >= m_cfg.durationS && m_pending.isEmpty()) {
+            report(true);
+            QCoreApplication::quit();
+        }
+    }
+
+    void flush() {
+        qint64 allowed = m_pending.size();
+        if (m_cfg.byteRate > 0 && m_realtime) {
+            allowed = qMin(allowed, qint64(m_clock.nsecsElapsed() / 1e9 * m_cfg.byteRate) - m_bytesOut);
+        }
+        if (allowed > 0) {
+            qint64 w = m_sink->write(m_pending.constData(), allowed);
+            m_bytesOut += w;
+            m_pending.remove(0, int(w));
+        }
+        if (m_pending.size() > kMaxPendingBytes) {
+            m_droppedBytes += m_pending.size();
+            m_pending.clear();
+        }
+    }
+
+    void report(bool final) {
+        const qint64 nowMs = m_clock.elapsed();
+        if (!final && nowMs - m_lastReportMs < 1000) return;
+        const double dt = qMax<qint64>(1, nowMs - m_lastReportMs) / 1000.0;
+        QTextStream(stderr) << QString("[PowerSim] %1 samples/s  %2 KB/s  total %3 samples, dropped %4 bytes\n")
+                                   .arg((m_generatedSamples - m_lastSamples) / dt, 0, 'f', 0)
+                                   .arg((m_bytesOut - m_lastBytes) / dt / 1024.0, 0, 'f', 1)
+                                   .arg(m_generatedSamples)
+                                   .arg(m_droppedBytes);
+        m_lastReportMs = nowMs;
+        m_lastSamples = m_generatedSamples;
+        m_lastBytes = m_bytesOut;
+    }
+
+    SimConfig m_cfg;
+    Sink* m_sink;
+    SignalModel m_model;
+    bool m_realtime;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QByteArray m_pending;
+    quint64 m_sampleIdx = 0;
+    quint64 m_generatedSamples = 0;
+    qint64 m_bytesOut = 0;
+    qint64 m_droppedBytes = 0;
+    qint64 m_lastReportMs = 0;
+    quint64 m_lastSamples = 0;
+    qint64 m_lastBytes = 0;
+};
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PowerSim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ProPower 多通道设备模拟器");
+    parser.addHelpOption();
+    QCommandLineOption optChannels("channels", "通道数 (1-255)", "n", "2");
+    QCommandLineOption optRate("rate", "每通道采样率 (Hz)", "hz", "20");
+    QCommandLineOption optFormat("format", "text 或 binary", "fmt", "text");
+    QCommandLineOption optNoise("noise", "电流噪声标准差 (mA)", "ma", "0.5");
+    QCommandLineOption optStepPeriod("step-period", "阶跃负载周期 (s)，0 关闭", "s", "0");
+    QCommandLineOption optStepMa("step-ma", "阶跃幅度 (mA)", "ma", "200");
+    QCommandLineOption optSpikeInterval("spike-interval", "尖峰间隔 (s)，0 关闭", "s", "0");
+    QCommandLineOption optSpikeMa("spike-ma", "尖峰幅度 (mA)", "ma", "1500");
+    QCommandLineOption optSpikeLen("spike-len", "尖峰宽度 (样本数)", "n", "3");
+    QCommandLineOption optByteRate("byte-rate", "链路带宽上限 (B/s)，如 11520 模拟 115200 波特，0 不限", "bps", "0");
+    QCommandLineOption optDuration("duration", "运行时长 (s)，0 一直运行", "s", "0");
+    QCommandLineOption optPty("pty", "创建伪终端并输出到其中（默认）");
+    QCommandLineOption optTcp("tcp", "在 127.0.0.1:<port> 监听并输出到所有客户端", "port");
+    QCommandLineOption optFile("file", "尽快生成并写入文件（需配合 --duration）", "path");
+    parser.addOptions({ optChannels, optRate, optFormat, optNoise, optStepPeriod, optStepMa,
+                        optSpikeInterval, optSpikeMa, optSpikeLen, optByteRate, optDuration,
+                        optPty, optTcp, optFile });
+    parser.process(app);
+
+    SimConfig cfg;
+    cfg.channels = qBound(1, parser.value(optChannels).toInt(), 255);
+    cfg.rateHz = qMax(0.001, parser.value(optRate).toDouble());
+    cfg.binary = parser.value(optFormat) == "binary";
+    cfg.noiseMa = parser.value(optNoise).toDouble();
+    cfg.stepPeriodS = parser.value(optStepPeriod).toDouble();
+    cfg.stepMa = parser.value(optStepMa).toDouble();
+    cfg.spikeIntervalS = parser.value(optSpikeInterval).toDouble();
+    cfg.spikeMa = parser.value(optSpikeMa).toDouble();
+    cfg.spikeLen = qMax(1, parser.value(optSpikeLen).toInt());
+    cfg.byteRate = parser.value(optByteRate).toLongLong();
+    cfg.durationS = parser.value(optDuration).toDouble();
+
+    QTextStream err(stderr);
+    std::unique_ptr<Sink> sink;
+    bool realtime = true;
+
+    if (parser.isSet(optFile)) {
+        if (cfg.durationS <= 0.0) {
+            err << "--file 需要指定 --duration\n";
+            return 1;
+        }
+        auto file = std::make_unique<FileSink>(parser.value(optFile));
+        if (!file->open()) {
+            err << "无法写入文件 " << parser.value(optFile) << "\n";
+            return 1;
+        }
+        sink = std::move(file);
+        realtime = false;
+    } else if (parser.isSet(optTcp)) {
+        auto tcp = std::make_unique<TcpSink>();
+        quint16 port = quint16(parser.value(optTcp).toUInt());
+        if (!tcp->listen(port)) {
+            err << "无法监听端口 " << port << "\n";
+            return 1;
+        }
+        err << "[PowerSim] 连接 tcp:127.0.0.1:" << port << "\n";
+        sink = std::move(tcp);
+    } else {
+#ifdef Q_OS_UNIX
+        auto pty = std::make_unique<PtySink>();
+        if (!pty->open()) {
+            err << "无法创建伪终端\n";
+            return 1;
+        }
+        err << "[PowerSim] 连接 pty:" << pty->path() << "\n";
+        sink = std::move(pty);
+#else
+        err << "当前平台不支持伪终端，请使用 --tcp 或 --file\n";
+        return 1;
+#endif
+    }
+    err << QString("[PowerSim] %1 通道 x %2 Hz, %3\n")
+               .arg(cfg.channels).arg(cfg.rateHz).arg(cfg.binary ? "binary" : "text");
+    err.flush();
+
+    Simulator sim(cfg, sink.get(), realtime);
+    sim.start();
+    return app.exec();
+}
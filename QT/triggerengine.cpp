@@ -0,0 +1,77 @@
+#include "triggerengine.h"
+
+void TriggerEngine::setConfig(const TriggerConfig& config) {
+    m_config = config;
+    m_config.preSamples = qMax(0, m_config.preSamples);
+    m_config.postSamples = qMax(1, m_config.postSamples);
+    m_count = 0;
+    m_hasReady = false;
+    m_state = State::Stopped;
+    arm();
+}
+
+void TriggerEngine::arm() {
+    if (!enabled()) return;
+    m_state = State::Armed;
+    m_havePrev = false;
+    m_inPulse = false;
+    m_pulseValid = false;
+}
+
+void TriggerEngine::evaluate(quint64 idx, float x, quint64 t_ns) {
+    const TriggerConfig& c = m_config;
+    const bool rising = c.polarity == TriggerConfig::Polarity::Rising;
+    const bool above = rising ? x >= c.level : x <= c.level;
+    if (!m_havePrev) m_armedNs = t_ns;
+
+    bool hit = false;
+    switch (c.type) {
+    case TriggerConfig::Type::Edge:
+        hit = m_havePrev && above && (rising ? m_prev < c.level : m_prev > c.level);
+        break;
+    case TriggerConfig::Type::Level:
+        hit = above;
+        break;
+    case TriggerConfig::Type::PulseWidth:
+        // 脉冲结束（回到电平另一侧）时才知道宽度，触发点在脉冲结束处
+        if (above && !m_inPulse) {
+            m_inPulse = true;
+            m_pulseValid = m_havePrev;
+            m_pulseStartNs = t_ns;
+        } else if (!above && m_inPulse) {
+            m_inPulse = false;
+            const quint64 width = (t_ns > m_pulseStartNs) ? t_ns - m_pulseStartNs : 0;
+            hit = m_pulseValid && width >= c.minWidthNs && (c.maxWidthNs == 0 || width <= c.maxWidthNs);
+        }
+        break;
+    }
+    m_prev = x;
+    m_havePrev = true;
+
+    if (hit) start(idx, false);
+    else if (c.mode == TriggerConfig::Mode::Auto && t_ns > m_armedNs && t_ns - m_armedNs >= c.autoTimeoutNs) start(idx, true);
+}
+
+void TriggerEngine::start(quint64 idx, bool forced) {
+    m_pending.trigger = idx;
+    m_pending.first = idx - qMin(idx, quint64(m_config.preSamples));
+    m_pending.last = idx + quint64(m_config.postSamples);
+    m_pending.forced = forced;
+    m_state = State::Collecting;
+    if (idx + 1 >= m_pending.last) complete();
+}
+
+void TriggerEngine::complete() {
+    m_ready = m_pending;
+    m_hasReady = true;
+    ++m_count;
+    if (m_config.mode == TriggerConfig::Mode::Single) m_state = State::Stopped;
+    else arm();
+}
+
+bool TriggerEngine::takeCapture(TriggerCapture& out) {
+    if (!m_hasReady) return false;
+    out = m_ready;
+    m_hasReady = false;
+    return true;
+}
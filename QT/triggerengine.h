@@ -0,0 +1,91 @@
+#pragma once
+#include <QtGlobal>
+#include "samplestore.h"
+
+// 触发设置
+struct TriggerConfig {
+    enum class Mode { Off, Auto, Normal, Single };
+    enum class Type { Edge, Level, PulseWidth };
+    // 边沿：上升 / 下降；电平：高于 / 低于；脉宽：正脉冲（高于电平的一段）/ 负脉冲
+    enum class Polarity { Rising, Falling };
+
+    Mode mode = Mode::Off;
+    Type type = Type::Edge;
+    Polarity polarity = Polarity::Rising;
+    Series source = Series::I;
+    float level = 0.0f;
+    quint64 minWidthNs = 0;               // 脉宽触发的范围，0 表示不限
+    quint64 maxWidthNs = 0;
+    int preSamples = 1000;                // 触发点之前
+    int postSamples = 4000;               // 触发点及之后
+    quint64 autoTimeoutNs = 200000000ULL; // 自动模式：这么久没触发就强制采一次
+};
+
+// 一次采集：逻辑下标 [first, last)，trigger 为触发的那个样本
+struct TriggerCapture {
+    quint64 first = 0;
+    quint64 last = 0;
+    quint64 trigger = 0;
+    bool forced = false; // 自动模式超时强制采集，没有真正的触发点
+};
+
+// 一个通道的触发引擎，像硬件示波器一样逐样本判断
+//
+// feed() 在样本写入历史之后调用，与 WindowStats / EnergyMeter 同一处，每个样本都判断，
+// 与界面刷新率无关。判断只看当前样本和几个状态量，O(1)，不读历史。
+// 触发后再收 postSamples 个样本窗口就齐了；样本本身已经在 SampleStore 里，
+// 采集结果只是一个下标区间，由调用方在快照上冻结 (SampleView)，不复制样本。
+//
+// 单次模式采完一次就停，arm() 再来；正常模式采完立即重新布防；
+// 自动模式在正常模式基础上，超时没触发就强制采一次，画面不会一直停着。
+class TriggerEngine {
+public:
+    enum class State { Stopped, Armed, Collecting };
+
+    // 换设置后重新布防；Off 时停止
+    void setConfig(const TriggerConfig& config);
+    const TriggerConfig& config() const { return m_config; }
+    State state() const { return m_state; }
+    bool enabled() const { return m_config.mode != TriggerConfig::Mode::Off; }
+
+    // 重新布防（丢掉正在收的窗口）；Off 时无效
+    void arm();
+    void stop() { m_state = State::Stopped; }
+
+    // idx 为样本在 SampleStore 里的逻辑下标，须逐个递增
+    void feed(quint64 idx, float v, float i, float p, quint64 t_ns) {
+        if (m_state == State::Stopped) return;
+        if (m_state == State::Collecting) {
+            if (idx + 1 >= m_pending.last) complete();
+            return;
+        }
+        const float vals[kSeriesCount] = { v, i, p };
+        evaluate(idx, vals[int(m_config.source)], t_ns);
+    }
+
+    // 取出最近一次完成的采集；没有新的返回 false
+    bool takeCapture(TriggerCapture& out);
+    // 布防以来的触发次数（含强制采集）
+    quint64 count() const { return m_count; }
+
+private:
+    void evaluate(quint64 idx, float x, quint64 t_ns);
+    void start(quint64 idx, bool forced);
+    void complete();
+
+    TriggerConfig m_config;
+    State m_state = State::Stopped;
+    quint64 m_count = 0;
+
+    // 布防以来的判断状态
+    bool m_havePrev = false;
+    float m_prev = 0.0f;
+    quint64 m_armedNs = 0;
+    bool m_inPulse = false;
+    bool m_pulseValid = false; // 布防时已经在脉冲里，起点未知，这个脉冲不算
+    quint64 m_pulseStartNs = 0;
+
+    TriggerCapture m_pending;
+    TriggerCapture m_ready;
+    bool m_hasReady = false;
+};
@@ -0,0 +1,146 @@
+#include "windowstats.h"
+#include <cmath>
+
+void WindowStats::setWindow(quint64 windowNs, const SampleStore& store) {
+    m_windowNs = windowNs;
+    rebuild(store);
+}
+
+void WindowStats::reset(const SampleStore& store) {
+    for (int s = 0; s < kSeriesCount; ++s) {
+        m_sum[s] = 0.0;
+        m_sumSq[s] = 0.0;
+        m_min[s].clear();
+        m_max[s].clear();
+    }
+    m_energy = 0.0;
+    m_tail = m_head = store.end();
+    m_pending.clear();
+}
+
+void WindowStats::rebuild(const SampleStore& store) {
+    reset(store);
+    if (store.empty()) return;
+
+    const quint64 tEnd = store.time(store.end() - 1);
+    const quint64 tStart = (tEnd > m_windowNs) ? tEnd - m_windowNs : 0;
+    quint64 first = store.end();
+    while (first > store.begin() && store.time(first - 1) >= tStart) --first;
+
+    m_tail = m_head = first;
+    for (quint64 idx = first; idx < store.end(); ++idx) {
+        const float vals[kSeriesCount] = { store.value(Series::V, idx), store.value(Series::I, idx),
+                                           store.value(Series::P, idx) };
+        addBack(idx, vals, store.time(idx));
+    }
+}
+
+void WindowStats::append(SampleStore& store, float v, float i, float p, quint64 t_ns) {
+    // 时间移出窗口的，以及这次 push 会覆盖掉的（不落盘时），趁还能读到先减掉
+    const quint64 tStart = (t_ns > m_windowNs) ? t_ns - m_windowNs : 0;
+    const quint64 keepFrom = store.nextBegin();
+    while (m_tail < m_head && (m_tail < keepFrom || m_tailT < tStart)) evictFront(store);
+
+    store.push(v, i, p, t_ns);
+
+    if (m_head != store.end() - 1 || m_tail < store.begin()) {
+        // 有人绕过 append 直接写了 store，或者封段失败、begin() 跳过了窗口里还没减掉的样本
+        // （那些样本已经读不出来）：从 store 里还在的样本重新对齐
+        rebuild(store);
+        return;
+    }
+    const float vals[kSeriesCount] = { v, i, p };
+    addBack(store.end() - 1, vals, t_ns);
+
+    // 累加和一直加了又减，每写满一段用金字塔重算一次，误差不会积累
+    if (m_head % SampleStore::kSegment == 0) reseed(store);
+}
+
+void WindowStats::reseed(const SampleStore& store) {
+    if (m_tail == m_head) return;
+    const ChannelAgg agg = store.aggregate(m_tail, m_head);
+    for (int s = 0; s < kSeriesCount; ++s) {
+        m_sum[s] = agg.series[s].sum;
+        m_sumSq[s] = agg.series[s].sumSq;
+    }
+}
+
+void WindowStats::addBack(quint64 idx, const float* vals, quint64 t_ns) {
+    for (int s = 0; s < kSeriesCount; ++s) {
+        const float x = vals[s];
+        m_sum[s] += x;
+        m_sumSq[s] += double(x) * x;
+
+        auto& mn = m_min[s];
+        while (!mn.empty() && mn.back().v >= x) mn.pop_back();
+        mn.push_back({ idx, x });
+        auto& mx = m_max[s];
+        while (!mx.empty() && mx.back().v <= x) mx.pop_back();
+        mx.push_back({ idx, x });
+    }
+
+    const float p = vals[int(Series::P)];
+    if (m_head == m_tail) {
+        m_tailP = p;
+        m_tailT = t_ns;
+    }
+    if (m_head > m_tail && t_ns > m_lastT) m_energy += (double(m_lastP) + p) / 2.0 * double(t_ns - m_lastT);
+    m_lastP = p;
+    m_lastT = t_ns;
+    m_head = idx + 1;
+}
+
+const WindowStats::Pending& WindowStats::pending(const SampleStore& store, quint64 idx) {
+    if (idx - m_pendingFirst >= m_pending.size()) {
+        // 从 idx 读到段尾（或窗口末尾）；同一段的样本连续读，磁盘段只解码一次
+        const quint64 stop = qMin(m_head, (idx / SampleStore::kSegment + 1) * SampleStore::kSegment);
+        m_pending.resize(size_t(stop - idx));
+        for (quint64 k = idx; k < stop; ++k) {
+            Pending& e = m_pending[size_t(k - idx)];
+            for (int s = 0; s < kSeriesCount; ++s) e.vals[s] = store.value(Series(s), k);
+            e.t_ns = store.time(k);
+        }
+        m_pendingFirst = idx;
+    }
+    return m_pending[size_t(idx - m_pendingFirst)];
+}
+
+void WindowStats::evictFront(const SampleStore& store) {
+    const quint64 idx = m_tail;
+    const Pending& e = pending(store, idx);
+    for (int s = 0; s < kSeriesCount; ++s) {
+        const float x = e.vals[s];
+        m_sum[s] -= x;
+        m_sumSq[s] -= double(x) * x;
+        if (!m_min[s].empty() && m_min[s].front().idx == idx) m_min[s].pop_front();
+        if (!m_max[s].empty() && m_max[s].front().idx == idx) m_max[s].pop_front();
+    }
+
+    // 去掉 (idx, idx+1) 这一对的梯形，与 addBack 的算法一致
+    if (idx + 1 < m_head) {
+        const Pending& next = pending(store, idx + 1);
+        if (next.t_ns > m_tailT) m_energy -= (double(m_tailP) + next.vals[int(Series::P)]) / 2.0 * double(next.t_ns - m_tailT);
+        m_tailP = next.vals[int(Series::P)];
+        m_tailT = next.t_ns;
+    }
+    ++m_tail;
+
+    if (m_tail == m_head) {
+        // 窗口空了：累加和归零，顺便清掉浮点残差
+        for (int s = 0; s < kSeriesCount; ++s) { m_sum[s] = 0.0; m_sumSq[s] = 0.0; }
+        m_energy = 0.0;
+    }
+}
+
+WindowStats::Result WindowStats::stats(Series s) const {
+    Result r;
+    r.n = count();
+    if (r.n == 0) return r;
+
+    const int si = int(s);
+    r.min = m_min[si].front().v;
+    r.max = m_max[si].front().v;
+    r.avg = m_sum[si] / r.n;
+    r.rms = std::sqrt(qMax(0.0, m_sumSq[si]) / r.n);
+    return r;
+}
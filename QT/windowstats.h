@@ -0,0 +1,58 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include "samplestore.h"
+
+// 最近 N 秒的滑动窗口统计，样本进出窗口时增量更新
+// min/max 用单调队列，均值/RMS 用累加和，能量按梯形累加相邻样本对。
+// 每个样本摊还 O(1)，读取 O(1)。窗口里的样本不另存，出窗口时回到 SampleStore 按段顺序读：
+// 一次把队尾所在段剩下的样本读进自己的缓冲，之后逐个移出，不经过每线程的解码缓存，
+// 通道再多，每个压缩段每通道也只解码一次。
+// 累加和每写满一段从 SampleStore 的金字塔重算一次，浮点残差不随运行时间增长；
+// 封段失败等原因使窗口里的样本读不出来时，整个窗口按 store 里还在的样本重建。
+class WindowStats {
+public:
+    struct Result {
+        double min = 0.0, max = 0.0, avg = 0.0, rms = 0.0;
+        qint64 n = 0;
+    };
+
+    // 改窗口长度后从 store 里现有的样本重建一次
+    void setWindow(quint64 windowNs, const SampleStore& store);
+    quint64 window() const { return m_windowNs; }
+
+    // 代替 store.push()：先把即将被挤掉/移出窗口的样本减掉，再写入并计入新样本
+    void append(SampleStore& store, float v, float i, float p, quint64 t_ns);
+
+    // store.clear() 之后调用
+    void reset(const SampleStore& store);
+
+    Result stats(Series s) const;
+    double energyMWh() const { return m_energy / 3.6e12; }
+    qint64 count() const { return qint64(m_head - m_tail); }
+
+private:
+    struct Extreme { quint64 idx; float v; };
+    struct Pending { float vals[kSeriesCount]; quint64 t_ns; };
+
+    void evictFront(const SampleStore& store);
+    const Pending& pending(const SampleStore& store, quint64 idx);
+    void addBack(quint64 idx, const float* vals, quint64 t_ns);
+    void rebuild(const SampleStore& store);
+    void reseed(const SampleStore& store);
+
+    quint64 m_windowNs = 10ULL * 1000000000ULL;
+    quint64 m_tail = 0; // 窗口内最旧样本的逻辑下标
+    quint64 m_head = 0; // 窗口末尾（不含）
+    double m_sum[kSeriesCount] = {};
+    double m_sumSq[kSeriesCount] = {};
+    std::deque<Extreme> m_min[kSeriesCount]; // 值递增
+    std::deque<Extreme> m_max[kSeriesCount]; // 值递减
+    double m_energy = 0.0;                   // mW * ns
+    float m_lastP = 0.0f;
+    quint64 m_lastT = 0;
+    float m_tailP = 0.0f;  // 窗口内最旧样本的功率和时间戳，判断出窗口、减梯形用
+    quint64 m_tailT = 0;
+    std::vector<Pending> m_pending; // 待移出的样本 [m_pendingFirst, +size)，最多到段尾
+    quint64 m_pendingFirst = 0;
+};
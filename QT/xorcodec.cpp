@@ -0,0 +1,204 @@
+#include "xorcodec.h"
+#include <QtAlgorithms>
+#include <cmath>
+#include <cstring>
+
+namespace XorCodec {
+
+static inline quint32 floatBits(float f) { quint32 u; std::memcpy(&u, &f, 4); return u; }
+static inline float bitsFloat(quint32 u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+// 一个 XOR 值：
+//   '0'                         0
+//   '10' + 有效位               有效位落在上一次的窗口内
+//   '11' + 5 位前导零 + 5 位 (长度-1) + 有效位
+struct XorWindow {
+    int lead = -1, trail = 0; // 当前窗口；-1 表示还没有
+
+    void put(BitWriter& w, quint32 x) {
+        if (x == 0) {
+            w.put(0, 1);
+            return;
+        }
+        const int l = int(qCountLeadingZeroBits(x));
+        const int t = int(qCountTrailingZeroBits(x));
+        if (lead >= 0 && l >= lead && t >= trail) {
+            w.put(0b10, 2);
+            w.put(x >> trail, 32 - lead - trail);
+        } else {
+            const int len = 32 - l - t;
+            w.put(0b11, 2);
+            w.put(quint64(l), 5);
+            w.put(quint64(len - 1), 5);
+            w.put(x >> t, len);
+            lead = l;
+            trail = t;
+        }
+    }
+    quint32 get(BitReader& r) {
+        if (!r.bit()) return 0;
+        if (r.bit()) {
+            lead = int(r.get(5));
+            const int len = int(r.get(5)) + 1;
+            trail = 32 - lead - len;
+        }
+        return quint32(r.get(32 - lead - trail)) << trail;
+    }
+};
+
+// 值与上一个值 XOR，首值原样写入
+void encodeFloats(BitWriter& w, const float* v, int n) {
+    if (n <= 0) return;
+    quint32 prev = floatBits(v[0]);
+    w.put(prev, 32);
+
+    XorWindow win;
+    for (int k = 1; k < n; ++k) {
+        const quint32 cur = floatBits(v[k]);
+        win.put(w, cur ^ prev);
+        prev = cur;
+    }
+}
+
+void decodeFloats(BitReader& r, float* out, int n) {
+    if (n <= 0) return;
+    quint32 prev = quint32(r.get(32));
+    out[0] = bitsFloat(prev);
+
+    XorWindow win;
+    for (int k = 1; k < n; ++k) {
+        prev ^= win.get(r);
+        out[k] = bitsFloat(prev);
+    }
+}
+
+// 值与预测值 XOR，首值也一样；预测准时大多是 '0' 或低几位
+void encodePredicted(BitWriter& w, const float* v, const float* pred, int n) {
+    XorWindow win;
+    for (int k = 0; k < n; ++k) win.put(w, floatBits(v[k]) ^ floatBits(pred[k]));
+}
+
+void decodePredicted(BitReader& r, const float* pred, float* out, int n) {
+    XorWindow win;
+    for (int k = 0; k < n; ++k) out[k] = bitsFloat(floatBits(pred[k]) ^ win.get(r));
+}
+
+// ---- 寄存器刻度
+// 由粗到细：能用的第一个刻度整数最小，差分也最小
+
+static const double kDivisors[kScaleCount] = {
+    1e0, 2e0, 4e0, 5e0, 8e0, 1e1, 2e1, 4e1, 5e1, 8e1, 1e2, 2e2, 4e2, 5e2, 8e2, 1e3, 2e3, 4e3,
+    5e3, 8e3, 1e4, 2e4, 4e4, 5e4, 8e4, 1e5, 2e5, 4e5, 5e5, 8e5, 1e6, 2e6, 4e6, 5e6, 8e6,
+};
+
+static constexpr double kMaxScaled = double(1 << 30); // |k| 的上限：差分的 zigzag 不超过 32 位
+
+double scaleDivisor(int scale) { return kDivisors[scale]; }
+
+// 编码和解码用同一个式子，校验通过就保证逐位还原
+static inline float scaledValue(qint64 k, double divisor) { return float(double(k) / divisor); }
+
+static inline bool toScaled(float v, double divisor, qint64& k) {
+    const double x = double(v) * divisor;
+    if (!(std::fabs(x) < kMaxScaled)) return false; // 也挡掉 NaN / Inf
+    k = std::llround(x);
+    return floatBits(scaledValue(k, divisor)) == floatBits(v); // -0、非规格化数在这里落选
+}
+
+int findScale(const float* v, int n) {
+    for (int s = 0; s < kScaleCount; ++s) {
+        const double d = kDivisors[s];
+        qint64 k;
+        int j = 0;
+        while (j < n && toScaled(v[j], d, k)) ++j;
+        if (j == n) return s;
+    }
+    return -1;
+}
+
+static inline quint64 zigzag(qint64 x) { return (quint64(x) << 1) ^ quint64(x >> 63); }
+static inline qint64 unzigzag(quint64 z) { return qint64(z >> 1) ^ -qint64(z & 1); }
+
+// 32 位首值 (zigzag) + 6 位宽度 + (n - 1) 个定宽的差分 (zigzag)
+void encodeScaled(BitWriter& w, const float* v, int n, int scale) {
+    if (n <= 0) return;
+    const double d = kDivisors[scale];
+    qint64 prev = std::llround(double(v[0]) * d);
+    w.put(zigzag(prev), 32);
+
+    quint64 maxZ = 0;
+    for (int k = 1; k < n; ++k) {
+        const qint64 cur = std::llround(double(v[k]) * d);
+        maxZ |= zigzag(cur - prev);
+        prev = cur;
+    }
+    const int width = maxZ ? 64 - int(qCountLeadingZeroBits(maxZ)) : 0;
+    w.put(quint64(width), 6);
+    if (width == 0) return;
+
+    prev = std::llround(double(v[0]) * d);
+    for (int k = 1; k < n; ++k) {
+        const qint64 cur = std::llround(double(v[k]) * d);
+        w.put(zigzag(cur - prev), width);
+        prev = cur;
+    }
+}
+
+void decodeScaled(BitReader& r, float* out, int n, int scale) {
+    if (n <= 0) return;
+    const double d = kDivisors[scale];
+    qint64 cur = unzigzag(r.get(32));
+    out[0] = scaledValue(cur, d);
+
+    const int width = int(r.get(6));
+    if (width == 0) {
+        for (int k = 1; k < n; ++k) out[k] = out[0];
+        return;
+    }
+    for (int k = 1; k < n; ++k) {
+        cur += unzigzag(r.get(width));
+        out[k] = scaledValue(cur, d);
+    }
+}
+
+// 时间偏移：相邻差值的差 (dod)，zigzag 后按大小分档
+//   '0' dod = 0 | '10' + 7 位 | '110' + 12 位 | '1110' + 20 位 | '1111' + 36 位
+void encodeOffsets(BitWriter& w, const quint32* off, int n) {
+    if (n <= 0) return;
+    w.put(off[0], 32);
+
+    qint64 prevDelta = 0;
+    for (int k = 1; k < n; ++k) {
+        const qint64 delta = qint64(off[k]) - qint64(off[k - 1]);
+        const qint64 dod = delta - prevDelta;
+        prevDelta = delta;
+
+        const quint64 z = zigzag(dod);
+        if (z == 0)              { w.put(0, 1); }
+        else if (z < (1u << 7))  { w.put(0b10, 2);   w.put(z, 7); }
+        else if (z < (1u << 12)) { w.put(0b110, 3);  w.put(z, 12); }
+        else if (z < (1u << 20)) { w.put(0b1110, 4); w.put(z, 20); }
+        else                     { w.put(0b1111, 4); w.put(z, 36); }
+    }
+}
+
+void decodeOffsets(BitReader& r, quint32* out, int n) {
+    if (n <= 0) return;
+    out[0] = quint32(r.get(32));
+
+    qint64 delta = 0;
+    for (int k = 1; k < n; ++k) {
+        quint64 z = 0;
+        if (r.bit()) {
+            if (!r.bit()) z = r.get(7);
+            else if (!r.bit()) z = r.get(12);
+            else if (!r.bit()) z = r.get(20);
+            else z = r.get(36);
+        }
+        const qint64 dod = unzigzag(z);
+        delta += dod;
+        out[k] = quint32(qint64(out[k - 1]) + delta);
+    }
+}
+
+} // namespace XorCodec
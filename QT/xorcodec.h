@@ -0,0 +1,86 @@
+#pragma once
+#include <QtGlobal>
+#include <vector>
+
+// Gorilla 风格的浮点 XOR 压缩 + 时间偏移的二阶差分，外加寄存器刻度上的差分定宽打包
+// 位流按 64 位字、高位在前存放。每次 encode 都是独立的一段（首值原样写入），
+// 记下段起点的位偏移就可以从中间任意一段开始解码。
+// 所有编码都是无损的：解码结果与原值逐位相同（NaN、-0、非规格化数也一样）。
+namespace XorCodec {
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<quint64>& words) : m_words(words) {}
+
+    // 写 bits 的低 n 位，n = 1..64
+    void put(quint64 bits, int n) {
+        if (n < 64) bits &= (quint64(1) << n) - 1;
+        const int room = 64 - m_used;
+        if (n < room) {
+            m_cur |= bits << (room - n);
+            m_used += n;
+        } else {
+            const int rest = n - room;
+            m_cur |= (rest > 0) ? bits >> rest : bits;
+            m_words.push_back(m_cur);
+            m_cur = (rest > 0) ? bits << (64 - rest) : 0;
+            m_used = rest;
+        }
+    }
+
+    quint64 bitPos() const { return quint64(m_words.size()) * 64 + quint64(m_used); }
+
+    // 补齐最后一个字
+    void flush() {
+        if (m_used > 0) m_words.push_back(m_cur);
+        m_cur = 0;
+        m_used = 0;
+    }
+
+private:
+    std::vector<quint64>& m_words;
+    quint64 m_cur = 0;
+    int m_used = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const quint64* words, quint64 bitPos) : m_words(words), m_pos(bitPos) {}
+
+    // 读 n 位，n = 1..64
+    quint64 get(int n) {
+        const quint64 w = m_pos >> 6;
+        const int off = int(m_pos & 63);
+        m_pos += quint64(n);
+        quint64 v = m_words[w] << off;
+        if (off + n > 64) v |= m_words[w + 1] >> (64 - off);
+        return v >> (64 - n);
+    }
+    bool bit() { return get(1) != 0; }
+
+private:
+    const quint64* m_words;
+    quint64 m_pos;
+};
+
+void encodeFloats(BitWriter& w, const float* v, int n);
+void decodeFloats(BitReader& r, float* out, int n);
+
+// 与逐个预测值 XOR（功率按 V * I 预测），预测值须在解码时也能算出来
+void encodePredicted(BitWriter& w, const float* v, const float* pred, int n);
+void decodePredicted(BitReader& r, const float* pred, float* out, int n);
+
+// 寄存器刻度：INA226 这类传感器的读数是 整数 × LSB，文本协议是固定位数的小数。
+// 一段值都能写成 float(k / divisor) 时存整数 k 的差分，按段内最大差分定宽打包，
+// 安静的电源轨每个值只要几位。divisor 取 {1, 2, 4, 5, 8} × 10^e 中的一个。
+constexpr int kScaleCount = 35;
+double scaleDivisor(int scale);
+// 能无损还原这段值的最粗刻度，没有时返回 -1
+int findScale(const float* v, int n);
+void encodeScaled(BitWriter& w, const float* v, int n, int scale);
+void decodeScaled(BitReader& r, float* out, int n, int scale);
+
+void encodeOffsets(BitWriter& w, const quint32* off, int n);
+void decodeOffsets(BitReader& r, quint32* out, int n);
+
+} // namespace XorCodec